@@ -145,27 +145,23 @@ int EPROM_IICInit(XIic *IicInstancePtr){
 **
 **	Description:
 **		Reads nData data bytes from the consecutive registers starting at the specified register address.
+**		The address is sent followed by a repeated start (random read), so the whole burst is one
+**		I2C transaction. The device was enabled by EPROM_IICInit, the low level
+**		XIic_Send/XIic_Recv wait for the bus themselves.
 **
 */
 u8 EPROM_ReadIIC(EPROM* InstancePtr, u8 addr, u8 *Data, int nData)
 {
-	int Status;
-	Status = XIic_Start(&InstancePtr->EPROMIic);
-	if (Status != XST_SUCCESS) {
-		return ERRVAL_EPROM_READ;
-	}
+	unsigned Sent;
+	unsigned Received;
 
-	XIic_Send(InstancePtr->EPROMIic.BaseAddress, InstancePtr->chipAddr, &addr, 1, XIIC_STOP);
-	while(XIic_IsIicBusy(&InstancePtr->EPROMIic)) {
-		//xil_printf("waiting to write eeprom for read operation\r\n");
+	Sent = XIic_Send(InstancePtr->EPROMIic.BaseAddress, InstancePtr->chipAddr, &addr, 1, XIIC_REPEATED_START);
+	if (Sent != 1) {
+		return ERRVAL_EPROM_READ;
 	}
 
-	XIic_Recv(InstancePtr->EPROMIic.BaseAddress, InstancePtr->chipAddr, Data, nData, XIIC_STOP);
-	while(XIic_IsIicBusy(&InstancePtr->EPROMIic)) {
-		//xil_printf("waiting to read eeprom\r\n");
-	}
-	Status = XIic_Stop(&InstancePtr->EPROMIic);
-	if (Status != XST_SUCCESS) {
+	Received = XIic_Recv(InstancePtr->EPROMIic.BaseAddress, InstancePtr->chipAddr, Data, nData, XIIC_STOP);
+	if (Received != nData) {
 		return ERRVAL_EPROM_READ;
 	}
 	return ERRVAL_SUCCESS;
@@ -191,8 +187,7 @@ u8 EPROM_WriteIIC(EPROM* InstancePtr, u8 addr, u8 *Data, int nData)
 {
 
 	u8 out[17];
-	int Status;
-	int Sent;
+	unsigned Sent;
 	if(nData > 16)
 	{
 		nData = 16;
@@ -205,22 +200,8 @@ u8 EPROM_WriteIIC(EPROM* InstancePtr, u8 addr, u8 *Data, int nData)
 		out[i+1] = Data[i];
 	}
 
-	Status = XIic_Start(&InstancePtr->EPROMIic);
-	if (Status != XST_SUCCESS) {
-		return ERRVAL_EPROM_WRITE;
-	}
-
 	Sent = XIic_Send(InstancePtr->EPROMIic.BaseAddress, InstancePtr->chipAddr, out, nData+1, XIIC_STOP);
-	if (Sent == 0) {
-		//xil_printf("failed to write eeprom\r\n");
-	}
-
-	while(XIic_IsIicBusy(&InstancePtr->EPROMIic)) {
-		//xil_printf("waiting to write eeprom\r\n");
-	}
-
-	Status = XIic_Stop(&InstancePtr->EPROMIic);
-	if (Status != XST_SUCCESS) {
+	if (Sent != nData+1) {
 		return ERRVAL_EPROM_WRITE;
 	}
 	return ERRVAL_SUCCESS;
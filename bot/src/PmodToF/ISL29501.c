@@ -141,32 +141,23 @@ int ISL29501_IICInit(XIic *IicInstancePtr){
 **	u8	ERRVAL_SUCCESS 	- success
 **	Description:
 **		Reads nData data bytes from the consecutive registers starting at the specified register address.
+**		The register address is sent followed by a repeated start, so the whole burst is one
+**		I2C transaction. The device was enabled by ISL29501_IICInit, the low level
+**		XIic_Send/XIic_Recv wait for the bus themselves.
 **
 */
 u8 ISL29501_ReadIIC(ISL29501* InstancePtr, u8 reg, u8 *Data, int nData)
 {
-	int Status;
-	int Sent;
-	Status = XIic_Start(&InstancePtr->ISL29501Iic);
-	if (Status != XST_SUCCESS) {
-		return ERRVAL_ToF_READ;
-	}
+	unsigned Sent;
+	unsigned Received;
 
-	Sent = XIic_Send(InstancePtr->ISL29501Iic.BaseAddress, InstancePtr->chipAddr, &reg, 1, XIIC_STOP);
-	if (Sent == 0) {
-		//xil_printf("failed to write iic for read operation\r\n");
-	}
-	while(XIic_IsIicBusy(&InstancePtr->ISL29501Iic)) {
-		//xil_printf("waiting to write iic for read operation\r\n");
-	}
-
-	XIic_Recv(InstancePtr->ISL29501Iic.BaseAddress, InstancePtr->chipAddr, Data, nData, XIIC_STOP);
-	while(XIic_IsIicBusy(&InstancePtr->ISL29501Iic)) {
-		//xil_printf("waiting to read iic\r\n");
+	Sent = XIic_Send(InstancePtr->ISL29501Iic.BaseAddress, InstancePtr->chipAddr, &reg, 1, XIIC_REPEATED_START);
+	if (Sent != 1) {
+		return ERRVAL_ToF_READ;
 	}
 
-	Status = XIic_Stop(&InstancePtr->ISL29501Iic);
-	if (Status != XST_SUCCESS) {
+	Received = XIic_Recv(InstancePtr->ISL29501Iic.BaseAddress, InstancePtr->chipAddr, Data, nData, XIIC_STOP);
+	if (Received != nData) {
 		return ERRVAL_ToF_READ;
 	}
 	return ERRVAL_SUCCESS;
@@ -186,37 +177,73 @@ u8 ISL29501_ReadIIC(ISL29501* InstancePtr, u8 reg, u8 *Data, int nData)
 **	u8	ERRVAL_SUCCESS 	- success
 **	Description:
 **		Writes nData data bytes to the consecutive registers starting at the specified register address.
+**		Up to ISL29501_MAX_BURST bytes are written in one I2C transaction, longer writes are split.
 **
 */
 u8 ISL29501_WriteIIC(ISL29501* InstancePtr, u8 reg, u8 *Data, int nData)
 {
-	u8 out[10];
-	out[0]=reg;
-//	out[1]=*Data;
-	for(int i = 0; i < nData; i++)
-	{
-		out[i+1] = Data[i];
-	}
-	int Status;
-	int Sent;
-
-	Status = XIic_Start(&InstancePtr->ISL29501Iic);
-	if (Status != XST_SUCCESS) {
-		return ERRVAL_ToF_WRITE;
-	}
+	u8 out[ISL29501_MAX_BURST + 1];
+	int nBurst;
+	unsigned Sent;
 
-	Sent = XIic_Send(InstancePtr->ISL29501Iic.BaseAddress, InstancePtr->chipAddr, out, nData+1, XIIC_STOP);
-	if (Sent == 0) {
-		//xil_printf("failed to write iic\r\n");
+	while(nData > 0)
+	{
+		nBurst = nData < ISL29501_MAX_BURST ? nData : ISL29501_MAX_BURST;
+		out[0]=reg;
+		for(int i = 0; i < nBurst; i++)
+		{
+			out[i+1] = Data[i];
+		}
+
+		Sent = XIic_Send(InstancePtr->ISL29501Iic.BaseAddress, InstancePtr->chipAddr, out, nBurst+1, XIIC_STOP);
+		if (Sent != nBurst+1) {
+			return ERRVAL_ToF_WRITE;
+		}
+		reg += nBurst;
+		Data += nBurst;
+		nData -= nBurst;
 	}
+	return ERRVAL_SUCCESS;
+}
 
-	while(XIic_IsIicBusy(&InstancePtr->ISL29501Iic)) {
-		//xil_printf("waiting to write iic\r\n");
-	}
+/* ------------------------------------------------------------ */
+/***	ISL29501_WriteRegTable
+**
+**	Parameters:
+**		InstancePtr - ISL29501 object to initialize
+**		pTable		- register/value pairs, written in table order
+**		nEntries	- number of entries in the table
+**
+**	Return Value:
+**	u8	ERRVAL_ToF_WRITE - failed to write ISL29501 registers over I2C communication
+**	u8	ERRVAL_SUCCESS 	- success
+**	Description:
+**		Writes a table of register values, such as an initialization or calibration sequence.
+**		Consecutive entries with consecutive register addresses are merged into one burst write,
+**		so a table sorted by address takes as few I2C transactions as possible.
+**
+*/
+u8 ISL29501_WriteRegTable(ISL29501* InstancePtr, const ISL29501_REG *pTable, int nEntries)
+{
+	u8 burst[ISL29501_MAX_BURST];
+	int nBurst;
+	u8 result;
 
-	Status = XIic_Stop(&InstancePtr->ISL29501Iic);
-	if (Status != XST_SUCCESS) {
-		return ERRVAL_ToF_WRITE;
+	for(int i = 0; i < nEntries; i += nBurst)
+	{
+		nBurst = 0;
+		do
+		{
+			burst[nBurst] = pTable[i + nBurst].value;
+			nBurst++;
+		} while(i + nBurst < nEntries && nBurst < ISL29501_MAX_BURST
+				&& pTable[i + nBurst].reg == pTable[i].reg + nBurst);
+
+		result = ISL29501_WriteIIC(InstancePtr, pTable[i].reg, burst, nBurst);
+		if(result != ERRVAL_SUCCESS)
+		{
+			return result;
+		}
 	}
 	return ERRVAL_SUCCESS;
 }
@@ -90,6 +90,11 @@
 /*				Bit masks Definitions							*/
 /* ------------------------------------------------------------ */
 
+/* ------------------------------------------------------------ */
+/*				Burst access									*/
+/* ------------------------------------------------------------ */
+#define ISL29501_MAX_BURST 16	// data bytes sent in one I2C write transaction
+
 
 /* ------------------------------------------------------------ */
 /*					Procedure Declarations						*/
@@ -106,9 +111,16 @@ typedef struct ISL29501{
 #endif
 }ISL29501;
 
+// Register table entry for ISL29501_WriteRegTable
+typedef struct ISL29501_REG{
+	u8 reg;
+	u8 value;
+}ISL29501_REG;
+
 void ISL29501_begin(ISL29501* InstancePtr, u32 IIC_Address, u8 Chip_Address);
 u8 ISL29501_ReadIIC(ISL29501* InstancePtr, u8 reg, u8 *Data, int nData);
 u8 ISL29501_WriteIIC(ISL29501* InstancePtr, u8 reg, u8 *Data, int nData);
+u8 ISL29501_WriteRegTable(ISL29501* InstancePtr, const ISL29501_REG *pTable, int nEntries);
 
 
 
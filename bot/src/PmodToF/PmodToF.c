@@ -19,6 +19,9 @@
 /* This file contains library functions for performing calibration and           */
 /* measurement. Calibration ensure the measurement accuracy by making            */
 /* adjustments to correct the measurements error.                                */
+/* In continuous ranging mode measurements are triggered from a timer tick and  */
+/* read by the data ready interrupt into a ring buffer, so reading a distance    */
+/* never blocks.                                                                 */
 /*                                                                               */
 /* More details can be found at:												 */
 /*                                                                               */
@@ -58,6 +61,62 @@ XGpio gpio;
 CALIBDATA calib;
 SERIALNODATA serialNo ;
 
+/* ------------------------------------------------------------- */
+/* ---------------------------!!!------------------------------- */
+/* ---------------------------!!!------------------------------- */
+/* ---------------------------!!!------------------------------- */
+
+//These values are the standard values chosen by Digilent for this device.The user must be very carefully if he wishes to change them.
+//Please read ISL29501 documentation before proceeding.
+//Check https://reference.digilentinc.com/reference/pmod/pmodtof/zynqlibraryuserguide for additional details
+//The user must modify these values before performing manual calibration,
+//but the user should make a backup of them, in case it is needed to be restored
+//Registers are written in the order of the Chip Initialization steps (an1724.pdf),
+//consecutive addresses go in one I2C burst.
+static const ISL29501_REG initRegs[] =
+{
+	{ 0x10, 0x04 },
+	{ 0x11, 0x6E },
+	{ SAMPLE_CONTROL_REG, 0x71 },
+	{ INTERRUPT_CONTROL_REG, 0x01 },
+	{ 0x18, 0x22 },
+	{ 0x19, 0x22 },
+	{ 0x90, 0x0F },
+	{ 0x91, 0xFF },
+};
+/* ------------------------------------------------------------ */
+
+//single shot distance measurement, data ready interrupt enabled
+static const ISL29501_REG distanceMeasurementRegs[] =
+{
+	{ SAMPLE_CONTROL_REG, 0x7D },
+	{ INTERRUPT_CONTROL_REG, 0x01 },
+};
+
+#define REG_TABLE_SIZE(table) (sizeof(table) / sizeof((table)[0]))
+
+/* ------------------------------------------------------------ */
+/*					Continuous ranging state				    */
+/* ------------------------------------------------------------ */
+typedef struct _RANGING{
+	volatile bool running;
+	u32 tickRateHz;					// rate PmodToF_ranging_tick is called at
+	u32 periodTicks;				// ticks between two Sample Start pulses
+	u32 lowTicks;					// ticks SS is held low
+	u32 timeoutTicks;				// ticks to wait for data ready
+	volatile u32 ticks;				// ticks since ranging started
+	u32 triggerTick;				// tick of the last Sample Start pulse
+	bool ssLow;
+	volatile bool pending;			// a measurement was triggered and not read yet
+	volatile bool dataReady;		// data ready seen by the interrupt, distance not read yet
+	volatile u32 readyMs;			// ranging time of the data ready interrupt
+	volatile TOFSAMPLE ring[TOF_RING_SIZE];
+	volatile u32 head;				// samples written since ranging started
+	u32 tail;						// samples consumed by PmodToF_read_sample
+} RANGING;
+
+static RANGING ranging;
+
 
 /* ------------------------------------------------------------ */
 /*					Local functions used for calibration        */
@@ -81,6 +140,9 @@ double _3bytes_to_double(u8 EXP, u8 MSB, u8 LSB);
 double _2bytes_to_double(u8 MSB, u8 LSB);
 void double_to_3bytes(double AVG, u8* EXP, u8* MSB, u8* LSB);
 void double_to_2bytes(double AVG, u8* MSB, u8* LSB);
+void RANGING_DataReadyHandler(void *CallbackRef);
+void RANGING_ReadPendingSample();
+u32 RANGING_TicksFromUs(u32 tickRateHz, u32 us);
 
 /* ------------------------------------------------------------ */
 /** void  PmodToF_Initialize()
@@ -97,40 +159,13 @@ void double_to_2bytes(double AVG, u8* MSB, u8* LSB);
 **/
 void PmodToF_Initialize()
 {
-	/* ------------------------------------------------------------- */
-	/* ---------------------------!!!------------------------------- */
-	/* ---------------------------!!!------------------------------- */
-	/* ---------------------------!!!------------------------------- */
-
-	//These values are the standard values chosen by Digilent for this device.The user must be very carefully if he wishes to change them.
-	//Please read ISL29501 documentation before proceeding.
-	//Check https://reference.digilentinc.com/reference/pmod/pmodtof/zynqlibraryuserguide for additional details
-	//The user must modify these values before performing manual calibration,
-	//but the user should make a backup of them, in case it is needed to be restored
-	u8 reg0x10_data = 0x04;
-	u8 reg0x11_data = 0x6E;
-	u8 reg0x13_data = 0x71;
-	u8 reg0x60_data = 0x01;
-	u8 reg0x18_data = 0x22;
-	u8 reg0x19_data = 0x22;
-	u8 reg0x90_data = 0x0F;
-	u8 reg0x91_data = 0xFF;
-	/* ------------------------------------------------------------ */
-
 	ISL29501_begin(&myToFDevice, XPAR_IIC_0_BASEADDR,ISL29501_CHIP_ADDRESS);
     EPROM_begin(&myEPROMDevice, XPAR_IIC_0_BASEADDR, EPROM_CHIP_ADDRESS);
     XGpio_Initialize(&gpio, XPAR_GPIO_0_DEVICE_ID); //initialize input XGpio variable
     XGpio_SetDataDirection(&gpio, 1, GPIO_DIRMASK);
 
     //steps for ISL29501 Chip Initialization as described in an1724.pdf :
-    ISL29501_WriteIIC(&myToFDevice, 0x10, &reg0x10_data, 1);
-	ISL29501_WriteIIC(&myToFDevice, 0x11, &reg0x11_data, 1);
-	ISL29501_WriteIIC(&myToFDevice, 0x13, &reg0x13_data, 1);
-	ISL29501_WriteIIC(&myToFDevice, 0x60, &reg0x60_data, 1);
-	ISL29501_WriteIIC(&myToFDevice, 0x18, &reg0x18_data, 1);
-	ISL29501_WriteIIC(&myToFDevice, 0x19, &reg0x19_data, 1);
-	ISL29501_WriteIIC(&myToFDevice, 0x90, &reg0x90_data, 1);
-	ISL29501_WriteIIC(&myToFDevice, 0x91, &reg0x91_data, 1);
+    ISL29501_WriteRegTable(&myToFDevice, initRegs, REG_TABLE_SIZE(initRegs));
 
 	PmodToF_ReadCalibsFromEPROM_User();
 }
@@ -144,6 +179,7 @@ void PmodToF_Initialize()
 **
 **  Return Value:
 **      distance - the distance in meters, measured by the PmodToF device
+**      -1       - continuous ranging is running and no sample arrived within TOF_MAX_SAMPLE_AGE_MS
 **
 **  Description:
 **  Function for performing a distance measurement.
@@ -153,32 +189,355 @@ void PmodToF_Initialize()
 **  It follows the steps as described in the Firmware Routines documentation (an1724.pdf)
 **  for making a distance measurement.
 **  As a result of measurement, the 0xD1 and 0xD2 registers are set with the values
-**  corresponding to DistanceMSB and DistanceLSB.
+**  corresponding to DistanceMSB and DistanceLSB. They are read in one I2C burst.
 **  The distance is computed starting from the values of these 2 registers using the 
 **  formula provided in the in the Firmware Routines documentation(an1724.pdf).
+**  When continuous ranging is running no measurement is started, the latest sample
+**  is returned, waiting only for the first one at most TOF_MAX_SAMPLE_AGE_MS.
 **/
 double PmodToF_perform_distance_measurement()
 {
-    /* WRITE REG */
-    u8 reg0x13_data = 0x7D;
-    u8 reg0x60_data = 0x01;
     /* READ REG */
     u8 unused;
-    u8 DistanceMSB;
-    u8 DistanceLSB;
+    u8 Distance[2];
+    TOFSAMPLE sample;
+    int retries = TOF_MAX_SAMPLE_AGE_MS;
 
     double distance = 1;
-    ISL29501_WriteIIC(&myToFDevice, 0x13, &reg0x13_data, 1);
-    ISL29501_WriteIIC(&myToFDevice, 0x60, &reg0x60_data, 1);
+    if(ranging.running)
+    {
+    	//the ISL29501 is owned by continuous ranging, return its latest sample
+    	while(!PmodToF_get_latest_sample(&sample))
+    	{
+    		if(retries-- == 0)
+    		{
+    			return -1;
+    		}
+    		usleep(1000);
+    	}
+    	return ((double)sample.rawDistance / 65536) * 33.31;
+    }
+    ISL29501_WriteRegTable(&myToFDevice, distanceMeasurementRegs, REG_TABLE_SIZE(distanceMeasurementRegs));
     ISL29501_ReadIIC(&myToFDevice, 0x69, &unused, 1);
     CALIB_initiate_calibration_measurement();
 	//waits for IRQ
     while((XGpio_DiscreteRead(&gpio, GPIO_CHANNEL) & GPIO_DATA_RDY_MSK) != 0 );
-    ISL29501_ReadIIC(&myToFDevice, 0xD1, &DistanceMSB, 1);
-    ISL29501_ReadIIC(&myToFDevice, 0xD2, &DistanceLSB, 1);
-    distance =(((double)DistanceMSB * 256 + (double)DistanceLSB)/65536) * 33.31;
+    ISL29501_ReadIIC(&myToFDevice, DISTANCE_READOUT_MSB_REG, Distance, 2);
+    distance =(((double)Distance[0] * 256 + (double)Distance[1])/65536) * 33.31;
     return  distance;
 }
+#ifndef NO_IRPT
+/* ------------------------------------------------------------ */
+/** uint8_t PmodToF_start_continuous_ranging(INTC *pIntc, u8 interruptId, u32 tickRateHz)
+**  Parameters:
+**      pIntc		- initialized interrupt controller
+**      interruptId	- interrupt ID of the Pmod ToF GPIO in the interrupt controller
+**      tickRateHz	- rate PmodToF_ranging_tick is called at, from a timer interrupt
+**
+**  Return Value:
+**      ERRVAL_SUCCESS					0		// success
+**      ERRVAL_FAILED_STARTING_MEASURE	0xEC	// failed to connect the data ready interrupt
+**      ERRVAL_ToF_WRITE				0xF8	// failed to configure the ISL29501
+**
+**  Description:
+**  Function for starting continuous distance measurements.
+**  The ISL29501 is configured once for distance measurement with the data ready interrupt enabled.
+**  From then on PmodToF_ranging_tick generates the Sample Start(SS) pulses, one every 20 ms,
+**  The data ready interrupt only timestamps the measurement, it does no I2C transfer. DistanceMSB
+**  and DistanceLSB are read in a single I2C transfer into a ring buffer of timestamped samples
+**  by the next call to PmodToF_get_latest_sample, PmodToF_read_sample or PmodToF_get_sample_count,
+**  from the main loop. A new measurement starts once the previous one was read, so they must be
+**  called at least every 20 ms to range at full rate.
+**  While ranging runs the ISL29501 and the EEPROM must not be accessed from elsewhere:
+**  calibration and the EEPROM functions return ERRVAL_RANGING_RUNNING.
+**  PmodToF_Initialize must be called first.
+**/
+uint8_t PmodToF_start_continuous_ranging(INTC *pIntc, u8 interruptId, u32 tickRateHz)
+{
+	/* READ REG */
+	u8 unused;
+	int Status;
+
+	if(ranging.running)
+	{
+		return ERRVAL_SUCCESS;
+	}
+	ranging.tickRateHz = tickRateHz;
+	ranging.periodTicks = RANGING_TicksFromUs(tickRateHz, TOF_SAMPLE_PERIOD_US);
+	ranging.lowTicks = RANGING_TicksFromUs(tickRateHz, TOF_SS_LOW_US);
+	ranging.timeoutTicks = ranging.periodTicks * TOF_TIMEOUT_PERIODS;
+	ranging.ticks = 0;
+	ranging.ssLow = false;
+	ranging.pending = false;
+	ranging.dataReady = false;
+	ranging.head = 0;
+	ranging.tail = 0;
+	// trigger on the first tick
+	ranging.triggerTick = -ranging.periodTicks;
+
+	XGpio_DiscreteWrite(&gpio, GPIO_CHANNEL, 0x1<<1); //SS -> "1";
+	if(ISL29501_WriteRegTable(&myToFDevice, distanceMeasurementRegs, REG_TABLE_SIZE(distanceMeasurementRegs))
+			!= ERRVAL_SUCCESS)
+	{
+		return ERRVAL_ToF_WRITE;
+	}
+	ISL29501_ReadIIC(&myToFDevice, INTERRUPT_STATUS_REG, &unused, 1);
+
+#ifdef XPAR_XINTC_NUM_INSTANCES
+	Status = XIntc_Connect(pIntc, interruptId, (XInterruptHandler)RANGING_DataReadyHandler, &gpio);
+#else
+	Status = XScuGic_Connect(pIntc, interruptId, (Xil_ExceptionHandler)RANGING_DataReadyHandler, &gpio);
+#endif
+	if(Status != XST_SUCCESS)
+	{
+		return ERRVAL_FAILED_STARTING_MEASURE;
+	}
+	XGpio_InterruptClear(&gpio, XGPIO_IR_CH1_MASK);
+	XGpio_InterruptEnable(&gpio, XGPIO_IR_CH1_MASK);
+	XGpio_InterruptGlobalEnable(&gpio);
+#ifdef XPAR_XINTC_NUM_INSTANCES
+	XIntc_Enable(pIntc, interruptId);
+#else
+	XScuGic_Enable(pIntc, interruptId);
+#endif
+
+	ranging.running = true;
+	return ERRVAL_SUCCESS;
+}
+#endif
+
+/* ------------------------------------------------------------ */
+/** void PmodToF_stop_continuous_ranging()
+**  Parameters:
+**      none
+**
+**  Return Value:
+**      none
+**
+**  Description:
+**  Function for stopping continuous distance measurements. The data ready interrupt is disabled
+**  and SS is left high. The samples already in the ring buffer can still be read.
+**/
+void PmodToF_stop_continuous_ranging()
+{
+	if(!ranging.running)
+	{
+		return;
+	}
+	ranging.running = false;
+	XGpio_InterruptDisable(&gpio, XGPIO_IR_CH1_MASK);
+	XGpio_InterruptGlobalDisable(&gpio);
+	XGpio_InterruptClear(&gpio, XGPIO_IR_CH1_MASK);
+	XGpio_DiscreteWrite(&gpio, GPIO_CHANNEL, 0x1<<1); //SS -> "1";
+	ranging.ssLow = false;
+	ranging.pending = false;
+	ranging.dataReady = false;
+}
+
+/* ------------------------------------------------------------ */
+/** bool PmodToF_is_ranging()
+**  Return Value:
+**      true if continuous ranging is running
+**/
+bool PmodToF_is_ranging()
+{
+	return ranging.running;
+}
+
+/* ------------------------------------------------------------ */
+/** void PmodToF_ranging_tick()
+**  Parameters:
+**      none
+**
+**  Return Value:
+**      none
+**
+**  Description:
+**  Function to be called from a timer interrupt at the rate given to PmodToF_start_continuous_ranging.
+**  It replaces the sleeps of CALIB_initiate_calibration_measurement: SS goes low at the start of
+**  every sample period and back high after 5.6 ms. A new measurement is only triggered once the
+**  previous one was read, or after TOF_TIMEOUT_PERIODS periods without data ready.
+**  It does nothing when continuous ranging is not running.
+**/
+void PmodToF_ranging_tick()
+{
+	u32 elapsed;
+
+	if(!ranging.running)
+	{
+		return;
+	}
+	ranging.ticks++;
+	elapsed = ranging.ticks - ranging.triggerTick;
+	if(ranging.ssLow && elapsed >= ranging.lowTicks)
+	{
+		XGpio_DiscreteWrite(&gpio, GPIO_CHANNEL, 0x1<<1); //SS -> "1";
+		ranging.ssLow = false;
+	}
+	if(elapsed >= ranging.periodTicks && (!ranging.pending || elapsed >= ranging.timeoutTicks))
+	{
+		XGpio_DiscreteWrite(&gpio, GPIO_CHANNEL, 0x0); //SS -> "0";
+		ranging.ssLow = true;
+		ranging.pending = true;
+		ranging.triggerTick = ranging.ticks;
+	}
+}
+
+/* ------------------------------------------------------------ */
+/** u32 PmodToF_get_ranging_time_ms()
+**  Return Value:
+**      milliseconds since continuous ranging started, in PmodToF_ranging_tick steps.
+**      Compare it with TOFSAMPLE.timeMs to get the age of a sample.
+**/
+u32 PmodToF_get_ranging_time_ms()
+{
+	return (u64)ranging.ticks * 1000 / ranging.tickRateHz;
+}
+
+/* ------------------------------------------------------------ */
+/** u32 PmodToF_get_sample_count()
+**  Return Value:
+**      number of samples measured since continuous ranging started.
+**      It changes when a new sample is available.
+**
+**  Description:
+**  Reads the pending sample over I2C first, call it from the main loop, not from an interrupt.
+**/
+u32 PmodToF_get_sample_count()
+{
+	RANGING_ReadPendingSample();
+	return ranging.head;
+}
+
+/* ------------------------------------------------------------ */
+/** bool PmodToF_get_latest_sample(TOFSAMPLE *pSample)
+**  Parameters:
+**      pSample - returns the most recent sample
+**
+**  Return Value:
+**      false if no sample was measured yet, true otherwise
+**
+**  Description:
+**  Non blocking read of the most recent continuous ranging sample. The pending sample is read
+**  over I2C first, call it from the main loop, not from an interrupt.
+**/
+bool PmodToF_get_latest_sample(TOFSAMPLE *pSample)
+{
+	u32 latest;
+
+	RANGING_ReadPendingSample();
+	do
+	{
+		latest = ranging.head - 1;
+		if(ranging.head == 0)
+		{
+			return false;
+		}
+		*pSample = ranging.ring[latest & (TOF_RING_SIZE - 1)];
+	} while(ranging.head - latest > TOF_RING_SIZE);
+	return true;
+}
+
+/* ------------------------------------------------------------ */
+/** bool PmodToF_read_sample(TOFSAMPLE *pSample)
+**  Parameters:
+**      pSample - returns the oldest sample not read yet
+**
+**  Return Value:
+**      false if there is no new sample, true otherwise
+**
+**  Description:
+**  Non blocking read of the continuous ranging samples in the order they were measured.
+**  When more than TOF_RING_SIZE samples were not read the oldest ones are lost.
+**  Only one reader may use this function. The pending sample is read over I2C first, call it
+**  from the main loop, not from an interrupt.
+**/
+bool PmodToF_read_sample(TOFSAMPLE *pSample)
+{
+	RANGING_ReadPendingSample();
+	do
+	{
+		if(ranging.tail == ranging.head)
+		{
+			return false;
+		}
+		if(ranging.head - ranging.tail > TOF_RING_SIZE)
+		{
+			ranging.tail = ranging.head - TOF_RING_SIZE;
+		}
+		*pSample = ranging.ring[ranging.tail & (TOF_RING_SIZE - 1)];
+	} while(ranging.head - ranging.tail > TOF_RING_SIZE);
+	ranging.tail++;
+	return true;
+}
+
+/* ------------------------------------------------------------ */
+/** void RANGING_DataReadyHandler(void *CallbackRef)
+**
+**  Description:
+**  Pmod ToF GPIO interrupt handler. The GPIO interrupts on every change of the IRQ pin;
+**  when it is low and a measurement is pending the time is recorded and the sample flagged
+**  for RANGING_ReadPendingSample. No I2C transfer is done here, the IIC controller is only
+**  used from the main loop and the control tick is not delayed.
+**/
+void RANGING_DataReadyHandler(void *CallbackRef)
+{
+	XGpio *pGpio = (XGpio *)CallbackRef;
+
+	XGpio_InterruptClear(pGpio, XGPIO_IR_CH1_MASK);
+	if(!ranging.running || !ranging.pending || ranging.dataReady
+			|| (XGpio_DiscreteRead(pGpio, GPIO_CHANNEL) & GPIO_DATA_RDY_MSK) != 0)
+	{
+		return;
+	}
+	ranging.readyMs = PmodToF_get_ranging_time_ms();
+	ranging.dataReady = true;
+}
+
+/* ------------------------------------------------------------ */
+/** void RANGING_ReadPendingSample()
+**
+**  Description:
+**  Reads the distance flagged by the data ready interrupt into the ring buffer, in one I2C
+**  transfer, timestamped with the interrupt time. Reading the interrupt status register
+**  releases the IRQ pin. Does nothing when no sample is pending. Main loop only.
+**/
+void RANGING_ReadPendingSample()
+{
+	u8 distance[2];
+	u8 unused;
+	volatile TOFSAMPLE *pSample;
+	u16 raw;
+
+	if(!ranging.running || !ranging.dataReady)
+	{
+		return;
+	}
+	if(ISL29501_ReadIIC(&myToFDevice, DISTANCE_READOUT_MSB_REG, distance, 2) == ERRVAL_SUCCESS)
+	{
+		raw = ((u16)distance[0] << 8) | distance[1];
+		pSample = &ranging.ring[ranging.head & (TOF_RING_SIZE - 1)];
+		pSample->timeMs = ranging.readyMs;
+		pSample->rawDistance = raw;
+		pSample->distanceMm = ((u32)raw * 33310) >> 16;
+		ranging.head++;
+	}
+	ISL29501_ReadIIC(&myToFDevice, INTERRUPT_STATUS_REG, &unused, 1);
+	ranging.dataReady = false;
+	ranging.pending = false;
+}
+
+/* ------------------------------------------------------------ */
+/** u32 RANGING_TicksFromUs(u32 tickRateHz, u32 us)
+**  Return Value:
+**      number of ticks, at least 1, lasting no less than us microseconds
+**/
+u32 RANGING_TicksFromUs(u32 tickRateHz, u32 us)
+{
+	u32 ticks = ((u64)us * tickRateHz + 999999) / 1000000;
+	return ticks ? ticks : 1;
+}
+
 /* ------------------------------------------------------------ */
 /** void CALIB_initiate_calibration__measurement()
 **  Parameters:
@@ -214,10 +573,16 @@ void CALIB_initiate_calibration_measurement()
 ** CALIB_perform_crosstalk_calibration, CALIB_perform_distance_calibration, as described in the Firmware Routines documentation(an1724.pdf)
 ** The function returns ERRVAL_INCORRECT_CALIB_DISTACE if the provided parameter is not larger than 0.05.
 ** The function returns ERRVAL_FAILED_STARTING_CALIB if the calibration cannot be started (at least one of ISL29501 or EPROM are busy).
+** The function returns ERRVAL_RANGING_RUNNING if continuous ranging is running.
 **/
 uint8_t PmodToF_start_calibration(double actual_distance)
 {
 	u8 bErrCode = ERRVAL_SUCCESS;
+	if (ranging.running)
+	{
+		bErrCode = ERRVAL_RANGING_RUNNING;
+		return bErrCode;
+	}
 	if (actual_distance == 0 || actual_distance < 0.05)
 	{
 		bErrCode = ERRVAL_INCORRECT_CALIB_DISTACE;
@@ -267,24 +632,28 @@ uint8_t PmodToF_start_calibration(double actual_distance)
 void CALIB_perform_magnitude_calibration()
 {
     /* WRITE REG */
-    u8 reg0x13_data = 0x61;
-    u8 reg0x60_data = 0x01;
+    static const ISL29501_REG startRegs[] =
+    {
+        { SAMPLE_CONTROL_REG, 0x61 },
+        { INTERRUPT_CONTROL_REG, 0x01 },
+    };
+    static const ISL29501_REG endRegs[] =
+    {
+        { SAMPLE_CONTROL_REG, 0x7D },
+        { INTERRUPT_CONTROL_REG, 0x00 },
+    };
     /* READ REG */
     u8 regs[3];
     u8 unused;
 
-    ISL29501_WriteIIC(&myToFDevice, 0x13, &reg0x13_data, 1);
-    ISL29501_WriteIIC(&myToFDevice, 0x60, &reg0x60_data, 1);
+    ISL29501_WriteRegTable(&myToFDevice, startRegs, REG_TABLE_SIZE(startRegs));
     ISL29501_ReadIIC(&myToFDevice, 0x69, &unused, 1);
     CALIB_initiate_calibration_measurement();
 	//waits for IRQ
     while((XGpio_DiscreteRead(&gpio, GPIO_CHANNEL) & GPIO_DATA_RDY_MSK) != 0 );
     ISL29501_ReadIIC(&myToFDevice, 0xF6, regs, 3);
-    ISL29501_WriteIIC(&myToFDevice, 0x2C, regs, 3);
-    reg0x13_data= 0x7D;
-    ISL29501_WriteIIC(&myToFDevice, 0x13, &reg0x13_data, 1);
-    reg0x60_data=0x00;
-    ISL29501_WriteIIC(&myToFDevice, 0x60, &reg0x60_data, 1);
+    ISL29501_WriteIIC(&myToFDevice, MAGNITUDE_REFERENCE_EXP, regs, 3);
+    ISL29501_WriteRegTable(&myToFDevice, endRegs, REG_TABLE_SIZE(endRegs));
 }
 
 /* ------------------------------------------------------------ */
@@ -302,9 +671,6 @@ void CALIB_perform_magnitude_calibration()
 void CALIB_perform_crosstalk_calibration()
 {
     int N= 100;
-    /* WRITE REG */
-    u8 reg0x13_data = 0x7D;
-    u8 reg0x60_data = 0x01;
     /* READ REG */
     u8 regs[14];
     u8 unused;
@@ -322,10 +688,10 @@ void CALIB_perform_crosstalk_calibration()
     u8 gain_lsb_calib;
     double gain_sum=0;
     double gain_avg;
+    u8 crosstalk[8];
 
 
-    ISL29501_WriteIIC(&myToFDevice, 0x13, &reg0x13_data, 1);
-    ISL29501_WriteIIC(&myToFDevice, 0x60, &reg0x60_data, 1);
+    ISL29501_WriteRegTable(&myToFDevice, distanceMeasurementRegs, REG_TABLE_SIZE(distanceMeasurementRegs));
 
     for(int i=0; i < N;i++)
     {
@@ -349,14 +715,16 @@ void CALIB_perform_crosstalk_calibration()
     double_to_3bytes(i_avg, &i_exp_calib, &i_msb_calib, &i_lsb_calib);
     double_to_3bytes(q_avg, &q_exp_calib, &q_msb_calib, &q_lsb_calib);
     double_to_2bytes(gain_avg, &gain_msb_calib, &gain_lsb_calib);
-    ISL29501_WriteIIC(&myToFDevice, 0x24, &i_exp_calib, 1);
-    ISL29501_WriteIIC(&myToFDevice, 0x25, &i_msb_calib, 1);
-    ISL29501_WriteIIC(&myToFDevice, 0x26, &i_lsb_calib, 1);
-    ISL29501_WriteIIC(&myToFDevice, 0x27, &q_exp_calib, 1);
-    ISL29501_WriteIIC(&myToFDevice, 0x28, &q_msb_calib, 1);
-    ISL29501_WriteIIC(&myToFDevice, 0x29, &q_lsb_calib, 1);
-    ISL29501_WriteIIC(&myToFDevice, 0x2A, &gain_msb_calib, 1);
-    ISL29501_WriteIIC(&myToFDevice, 0x2B, &gain_lsb_calib, 1);
+    //registers 0x24 to 0x2B, in one burst
+    crosstalk[0] = i_exp_calib;
+    crosstalk[1] = i_msb_calib;
+    crosstalk[2] = i_lsb_calib;
+    crosstalk[3] = q_exp_calib;
+    crosstalk[4] = q_msb_calib;
+    crosstalk[5] = q_lsb_calib;
+    crosstalk[6] = gain_msb_calib;
+    crosstalk[7] = gain_lsb_calib;
+    ISL29501_WriteIIC(&myToFDevice, CROSSTALK_I_EXPONENT, crosstalk, 8);
 
 }
 
@@ -376,23 +744,16 @@ void CALIB_perform_crosstalk_calibration()
 void CALIB_perform_distance_calibration(double actual_dist)
 {
     int N= 100;
-    /* WRITE REG */
-    u8 reg0x13_data = 0x7D;
-    u8 reg0x60_data = 0x01;
-
-
     /* READ REG */
     u8 regs[2];
     u8 unused;
     double phase_sum=0;
     double phase_avg;
     double dist_calib;
-    u8 dist_msb_calib;
-    u8 dist_lsb_calib;
+    u8 dist_calib_regs[2];
 
 
-    ISL29501_WriteIIC(&myToFDevice, 0x13, &reg0x13_data, 1);
-    ISL29501_WriteIIC(&myToFDevice, 0x60, &reg0x60_data, 1);
+    ISL29501_WriteRegTable(&myToFDevice, distanceMeasurementRegs, REG_TABLE_SIZE(distanceMeasurementRegs));
     for(int i=0; i < N;i++)
     {
         ISL29501_ReadIIC(&myToFDevice, 0x69, &unused, 1);
@@ -406,9 +767,8 @@ void CALIB_perform_distance_calibration(double actual_dist)
     }
     phase_avg= phase_sum / N;
     dist_calib = phase_avg - (actual_dist/33.31*65536);
-    double_to_2bytes(dist_calib, &dist_msb_calib, &dist_lsb_calib);
-    ISL29501_WriteIIC(&myToFDevice, 0x2F, &dist_msb_calib, 1);
-    ISL29501_WriteIIC(&myToFDevice, 0x30, &dist_lsb_calib, 1);
+    double_to_2bytes(dist_calib, &dist_calib_regs[0], &dist_calib_regs[1]);
+    ISL29501_WriteIIC(&myToFDevice, PHASE_OFFSET_MSB, dist_calib_regs, 2);
 
 }
 
@@ -464,10 +824,15 @@ uint8_t CALIB_WriteCalibsToEPROM_User(u8 msg_flag)
 **      This function should be called after changes were made in calibration data(after a manual calibration),
 **      in order to save them in the non-volatile memory.
 **		It returns ERRVAL_SUCCESS for success or the error codes provided by CALIB_WriteCalibsToEPROM_Raw function.
+**		It returns ERRVAL_RANGING_RUNNING if continuous ranging is running.
 **
 */
 uint8_t PmodToF_WriteCalibsToEPROM_User()
 {
+    if(ranging.running)
+    {
+        return ERRVAL_RANGING_RUNNING;
+    }
     return CALIB_WriteCalibsToEPROM_User(1);
 }
 
@@ -492,11 +857,16 @@ uint8_t PmodToF_WriteCalibsToEPROM_User()
 **      into ToF registers. If "skip_write_regs"= 1, calibration data will not be written into ToF registers.
 **      The function returns ERRVAL_SUCCESS for success or the error codes provided by  
 **		CALIB_ReadCalibsFromEPROM_Raw and CALIB_WriteCalibsToEPROM_Raw.
+**		It returns ERRVAL_RANGING_RUNNING if continuous ranging is running.
 **
 */
 uint8_t PmodToF_RestoreAllCalibsFromEPROM_Factory()
 {
     uint8_t bErrCode;
+    if(ranging.running)
+    {
+        return ERRVAL_RANGING_RUNNING;
+    }
     bErrCode = CALIB_ReadCalibsFromEPROM_Raw(&calib, (uint8_t)ADR_EPROM_FACTCALIB, 0);
     if(bErrCode == ERRVAL_SUCCESS)
     {
@@ -527,10 +897,15 @@ uint8_t PmodToF_RestoreAllCalibsFromEPROM_Factory()
 **      This function reads the user calibration data from EEPROM.
 **      It calls the local function CALIB_ReadAllCalibsFromEPROM_Raw providing the address of user calibration area in EPROM,
 **      The function returns ERRVAL_SUCCESS for success or the error codes provided by CALIB_ReadCalibsFromEPROM_Raw function.
+**      It returns ERRVAL_RANGING_RUNNING if continuous ranging is running.
 **
 */
 uint8_t PmodToF_ReadCalibsFromEPROM_User()
 {
+    if(ranging.running)
+    {
+        return ERRVAL_RANGING_RUNNING;
+    }
     return CALIB_ReadCalibsFromEPROM_Raw(&calib, (uint8_t)ADR_EPROM_CALIB,0);
 
 }
@@ -552,11 +927,16 @@ uint8_t PmodToF_ReadCalibsFromEPROM_User()
 **      The function returns ERRVAL_SUCCESS for success.
 **      The function returns ERRVAL_EPROM_MAGICNO when a wrong magic number was detected in the data read from EPROM.
 **      The function returns ERRVAL_EPROM_CRC when the checksum is wrong for the data read from EEPROM.
+**      The function returns ERRVAL_RANGING_RUNNING if continuous ranging is running.
 **
 */
 uint8_t PmodToF_ReadSerialNoFromEPROM(char *pSzSerialNo)
 {
     uint8_t bCrc, bCrcRead=0;
+    if(ranging.running)
+    {
+        return ERRVAL_RANGING_RUNNING;
+    }
     // read calibration structure
     EPROM_PageRead(&myEPROMDevice, ADR_EPROM_SERIALNO, (uint8_t *)&serialNo, sizeof(SERIALNODATA));
 
@@ -719,19 +1099,14 @@ uint8_t CALIB_Read_ISL29501_Regs()
 **	uint8_t		ERRVAL_ToF_WRITE	0xF8    // failed to write ISL29501 registers over I2C communication
 **  Description:
 **      This local function writes calibration data from the calib global structure 
-**		to the 13 ISL29501 calibration registers starting at 0x24 address, using the ISL29501_WriteIIC function.
+**		to the 13 ISL29501 calibration registers starting at 0x24 address, in one ISL29501_WriteIIC burst.
 **      The function returns ERRVAL_SUCCESS for success or the error codes provided by ISL29501_WriteIIC function.
 **
 */
 uint8_t CALIB_Write_ISL29501_Regs()
 {
-	uint8_t result=ERRVAL_SUCCESS;
-    for(int i = 0; i < 13; i++)
-    {
-        result=ISL29501_WriteIIC(&myToFDevice, ADR_OFFSET_CALIB_REG_ISL29501 + i, calib.regs + i, 1);
-        if(result != ERRVAL_SUCCESS)
-        return result;
-    }
+	uint8_t result;
+    result = ISL29501_WriteIIC(&myToFDevice, ADR_OFFSET_CALIB_REG_ISL29501, calib.regs, 13);
     return result;
 }
 
@@ -91,6 +91,7 @@
 #define ERRVAL_FAILED_STARTING_CALIB    0xFC    // failed to start calibration, EEPROM or ISL29501 device is busy
 #define ERRVAL_INCORRECT_CALIB_DISTACE  0xED	// incorrect calibration distance; it has to be more than 5 cm(0.05 m)
 #define ERRVAL_FAILED_STARTING_MEASURE	0xEC	// failed to start measurement
+#define ERRVAL_RANGING_RUNNING			0xEB	// continuous ranging owns the ISL29501 and EEPROM, stop it first
 
 
 /* ------------------------------------------------------------ */
@@ -116,6 +117,18 @@
 #define STATUS_REGISTERS 0x02
 #define DISTANCE_READOUT_MSB_REG 0xD1
 #define DISTANCE_READOUT_LSB_REG 0xD2
+#define INTERRUPT_CONTROL_REG 0x60
+#define INTERRUPT_STATUS_REG 0x69
+#define SAMPLE_CONTROL_REG 0x13
+
+/* ------------------------------------------------------------ */
+/*		 Continuous ranging									    */
+/* ------------------------------------------------------------ */
+#define TOF_RING_SIZE			16		// samples kept for PmodToF_read_sample, power of 2
+#define TOF_SAMPLE_PERIOD_US	20000	// Sample Start(SS) period, as in single measurements
+#define TOF_SS_LOW_US			5600	// time SS is held low to start a measurement
+#define TOF_TIMEOUT_PERIODS		5		// periods to wait for data ready before triggering again
+#define TOF_MAX_SAMPLE_AGE_MS	(TOF_TIMEOUT_PERIODS * TOF_SAMPLE_PERIOD_US / 1000)	// older samples are stale
 
 
 #ifdef XPAR_XINTC_NUM_INSTANCES
@@ -154,6 +167,13 @@ typedef struct _SERIALNODATA{    //
 }  __attribute__((__packed__)) SERIALNODATA;
 
 
+typedef struct _TOFSAMPLE{
+    u32 timeMs;			// ranging time the data ready interrupt was serviced, see PmodToF_get_ranging_time_ms
+    u16 rawDistance;	// DistanceMSB:DistanceLSB, 65536 is 33.31 m
+    u16 distanceMm;		// distance in millimeters
+} TOFSAMPLE;
+
+
 /* ------------------------------------------------------------ */
 /*					Public functions    						    */
 /* ------------------------------------------------------------ */
@@ -166,5 +186,16 @@ uint8_t PmodToF_ReadCalibsFromEPROM_User();
 uint8_t PmodToF_RestoreAllCalibsFromEPROM_Factory();
 uint8_t PmodToF_ReadSerialNoFromEPROM(char *pSzSerialNo);
 
+#ifndef NO_IRPT
+uint8_t PmodToF_start_continuous_ranging(INTC *pIntc, u8 interruptId, u32 tickRateHz);
+#endif
+void PmodToF_stop_continuous_ranging();
+bool PmodToF_is_ranging();
+void PmodToF_ranging_tick();
+u32 PmodToF_get_ranging_time_ms();
+u32 PmodToF_get_sample_count();
+bool PmodToF_get_latest_sample(TOFSAMPLE *pSample);
+bool PmodToF_read_sample(TOFSAMPLE *pSample);
+
 
 #endif // PmodToF_H
@@ -36,6 +36,7 @@
 /*                                                                      */
 /************************************************************************/
 #include "bot.h"
+#include "xil_exception.h"
 
 
 static MotorPosition motorPosition;
@@ -44,13 +45,19 @@ static PWMDriver pwmLeftMotor;
 static SpeedPIDController speedPIDController;
 static DistancePIDController distancePIDController;
 static LightPIDController lightPIDController;
+static PoseEstimator poseEstimator;
 static HBridgeDriver hbridge;
 static XTmrCtr timerPwmRightMotor;
 static XTmrCtr timerPwmLeftMotor;
+static XTmrCtr timerTick;
+static ControlTimer controlTimer;
+static XIntc intc;
 static XGpio GpioHbridge;
 static XGpio GpioSwitchsAndButtons;
 static XGpio GpioLedsAndRgbLeds;
 
+static void controlTick(void* callbackRef);
+
 /**
  * Initialize the BOT with the given driver references
  * @param drivers for inputs, outpus, display and driving
@@ -60,6 +67,7 @@ void BOT_init(BotDrivers* drivers) {
     BOT_init_gpio_outputs(&(drivers->rgbLedsDriver), &(drivers->ledsDriver));
     BOT_init_oled_display(&(drivers->oled));
     BOT_init_driving_driver(&(drivers->drivingDriver));
+    BOT_init_control_loop(&(drivers->drivingDriver));
     BOT_init_color_sensor(&(drivers->color));
 }
 
@@ -133,17 +141,24 @@ void BOT_init_driving_driver(DrivingDriver* botDriver) {
     HBRIDGE_DRIVER_init(&hbridge, &GpioHbridge, BOT_HBRIDGE_DEVICE_ID,
     BOT_HBRIDGE_CHANNEL, 0b0000, DIRECT_DIRECTION);
 
+    // the PID controllers output duty cycles in PWM timer ticks
+    u32 pwmPeriodTicks = PWM_DRIVER_get_period_ticks(&pwmRightMotor);
+
     SPEED_PID_CONTROLLER_init(&speedPIDController, BOT_SPEED_PID_K_PROPORTIONAL,
     BOT_SPEED_PID_K_INTEGRAL, BOT_SPEED_PID_K_DERIVATIVE,
-    BOT_BASE_DUTY_CYCLE);
+    BOT_BASE_DUTY_CYCLE, pwmPeriodTicks);
 
+    // the distance controller runs on every control tick, its gains are
+    // tuned at BOT_PID_TUNING_RATE_HZ
     DISTANCE_PID_CONTROLLER_init(&distancePIDController,
-    BOT_DISTANCE_PID_K_PROPORTIONAL, BOT_DISTANCE_PID_K_INTEGRAL,
-    BOT_DISTANCE_PID_K_DERIVATIVE, BOT_BASE_DUTY_CYCLE);
+    BOT_DISTANCE_PID_K_PROPORTIONAL,
+    BOT_DISTANCE_PID_K_INTEGRAL * BOT_PID_TUNING_RATE_HZ / BOT_CONTROL_RATE_HZ,
+    BOT_DISTANCE_PID_K_DERIVATIVE * BOT_CONTROL_RATE_HZ / BOT_PID_TUNING_RATE_HZ,
+    BOT_BASE_DUTY_CYCLE, pwmPeriodTicks);
 
     LIGHT_PID_CONTROLLER_init(&lightPIDController, BOT_LIGHT_PID_K_PROPORTIONAL,
     BOT_LIGHT_PID_K_INTEGRAL,
-    BOT_LIGHT_PID_K_DERIVATIVE, BOT_BASE_DUTY_CYCLE);
+    BOT_LIGHT_PID_K_DERIVATIVE, BOT_BASE_DUTY_CYCLE, pwmPeriodTicks);
 
 
     DRIVING_DRIVER_init(botDriver, &motorPosition, &pwmRightMotor,
@@ -152,4 +167,54 @@ void BOT_init_driving_driver(DrivingDriver* botDriver) {
             &hbridge, FRONT_SENSORS, BOT_DISTANCE_CORRECTION,
             BOT_DISTANCE_ARC_CORRECTION, BOT_BASE_DUTY_CYCLE, botDriver->colorSensor);
 
+    DRIVING_DRIVER_set_control_rate(botDriver, BOT_CONTROL_RATE_HZ,
+    BOT_PID_TUNING_RATE_HZ);
+    DRIVING_DRIVER_set_motion_profile(botDriver, BOT_DRIVE_SPEED_RPM,
+    BOT_PROFILE_ACCELERATION_RPM_S, BOT_PROFILE_MIN_RPM);
+
+    // updated on every control tick, velocity over a speed loop period
+    POSE_ESTIMATOR_init(&poseEstimator, BOT_DISTANCE_CORRECTION,
+    BOT_WHEEL_BASE_CM, BOT_CONTROL_RATE_HZ,
+    BOT_CONTROL_RATE_HZ / BOT_PID_TUNING_RATE_HZ);
+    DRIVING_DRIVER_set_pose_estimator(botDriver, &poseEstimator);
+
+}
+
+/**
+ * Initialize the interrupt controller and start the motion control tick
+ * @param botDriver    reference to Bot Driving Driver run by the tick
+ */
+void BOT_init_control_loop(DrivingDriver* botDriver) {
+    XIntc_Initialize(&intc, BOT_INTC_DEVICE_ID);
+
+    CONTROL_TIMER_init(&controlTimer, BOT_TICKTMRCTR_DEVICE_ID, &timerTick,
+    BOT_TICKTMRCTR_CLOCK_FREQ_HZ, BOT_CONTROL_RATE_HZ,
+            controlTick, botDriver);
+    CONTROL_TIMER_connect(&controlTimer, &intc, BOT_TICKTMRCTR_INTR);
+
+    XIntc_Start(&intc, XIN_REAL_MODE);
+
+    Xil_ExceptionInit();
+    Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+            (Xil_ExceptionHandler) XIntc_InterruptHandler, &intc);
+    Xil_ExceptionEnable();
+
+    CONTROL_TIMER_start(&controlTimer);
+}
+
+/**
+ * Initialize the Pmod ToF distance sensor and start continuous ranging,
+ * triggered by the control tick. Call it after BOT_init
+ */
+void BOT_init_distance_sensor() {
+    PmodToF_Initialize();
+    PmodToF_start_continuous_ranging(&intc, BOT_TOF_INTR, BOT_CONTROL_RATE_HZ);
+}
+
+/**
+ * Control tick: motion control and distance sensor sample start
+ */
+static void controlTick(void* callbackRef) {
+    DRIVING_DRIVER_control_tick(callbackRef);
+    PmodToF_ranging_tick();
 }
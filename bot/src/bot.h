@@ -42,6 +42,7 @@
 #include "drivers/buttons_driver.h"
 #include "drivers/distance_pid_control.h"
 #include "drivers/driving_driver.h"
+#include "drivers/control_timer.h"
 #include "drivers/switches_driver.h"
 #include "drivers/pwm_driver.h"
 #include "drivers/hbridge_driver.h"
@@ -71,8 +72,11 @@ void BOT_init_gpio_outputs(RgbLedsDriver* rgbLedsDriver, LedsDriver* ledsDriver)
 
 void BOT_init_driving_driver(DrivingDriver* drivingDriver);
 
+void BOT_init_control_loop(DrivingDriver* drivingDriver);
+
 void BOT_init_oled_display(PmodOLED *oled);
 
 void BOT_init_color_sensor(PmodCOLOR *colorSensor);
+void BOT_init_distance_sensor();
 
 #endif // __BOT_H_
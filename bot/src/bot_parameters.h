@@ -33,6 +33,8 @@
 /*  - Right Motor Timer /Counter Device ID                              */
 /*  - Left Motor Timer /Counter Device ID                               */
 /*  - Motor Speed PWM Control signal period in nanoseconds              */
+/*  - Interrupt controller and control loop tick Timer/Counter          */
+/*  - Motion control loop rate                                          */
 /*  - Motor position feedback AXI Base Address                          */
 /*  - Gear box motor ratio                                              */
 /*  - Motor Position Module Clock Frequency                             */
@@ -46,8 +48,10 @@
 /*  - Integral factor for the Traveled Distance PID control             */
 /*  - Derivative factor for the Traveled Distance PID control           */
 /*  - Base duty cycle, base speed for the PID controllers               */
+/*  - Velocity profile of moves and turns                               */
 /*  - Distance correction factor when rotating                          */
 /*  - Distance correction factors when driving straight                 */
+/*  - Distance between the wheels                                       */
 /*                                                                      */
 /*                                                                      */
 /************************************************************************/
@@ -89,6 +93,22 @@
 // Motor Speed PWM Control signal period in nanoseconds
 #define BOT_PWM_PERIOD                  10000000     /* PWM period in ns (100 Hz) */
 
+// AXI Interrupt Controller Device ID
+#define BOT_INTC_DEVICE_ID              XPAR_MICROBLAZE_0_AXI_INTC_DEVICE_ID
+// Control loop tick Timer /Counter Device ID and interrupt ID
+#define BOT_TICKTMRCTR_DEVICE_ID        XPAR_AXI_TIMER_TICK_DEVICE_ID
+#define BOT_TICKTMRCTR_INTR             XPAR_MICROBLAZE_0_AXI_INTC_AXI_TIMER_TICK_INTERRUPT_INTR
+// Tick Timer /Counter clock frequency
+#define BOT_TICKTMRCTR_CLOCK_FREQ_HZ    XPAR_AXI_TIMER_TICK_CLOCK_FREQ_HZ
+// Pmod ToF data ready (GPIO) interrupt ID
+#define BOT_TOF_INTR                    XPAR_MICROBLAZE_0_AXI_INTC_PMODTOF_0_IP2INTC_IRPT_INTR
+
+// Motion control loop rate in Hz, 200 to 1000
+#define BOT_CONTROL_RATE_HZ             200
+// Rate the speed and light PID gains are tuned for; these loops are
+// decimated to it, the encoders give too few edges per tick above it
+#define BOT_PID_TUNING_RATE_HZ          40
+
 // Motor position feedback AXI Base Address
 #define BOT_MOTORPOSITION_BASEADDR      XPAR_MOTORPOSITION_0_S00_AXI_BASEADDR
 
@@ -126,10 +146,18 @@
 // Base duty cycle, base speed for the PID controllers
 #define BOT_BASE_DUTY_CYCLE             0.6
 
+// Velocity profile: wheel cruise speed of straight moves, wheel acceleration
+// and the wheel speed moves start and end at
+#define BOT_DRIVE_SPEED_RPM             40
+#define BOT_PROFILE_ACCELERATION_RPM_S  100
+#define BOT_PROFILE_MIN_RPM             8
+
 // Distance correction factor when rotating
 #define BOT_DISTANCE_ARC_CORRECTION     15.2
 // Distance correction factors when driving straight
 #define BOT_DISTANCE_CORRECTION         15.5
+// Distance between the wheels in cm, for the dead reckoning
+#define BOT_WHEEL_BASE_CM               15.0
 
 // Proportional factor for the Lux Line difference e PID control
 #define BOT_LIGHT_PID_K_PROPORTIONAL 0.000001875
@@ -0,0 +1,143 @@
+/************************************************************************/
+/*                                                                      */
+/*  control_timer.c: Control loop tick timer for the ArtyBot.           */
+/*      This driver raises a periodic interrupt at a fixed rate         */
+/*  This file is part of the Arty S7 Bot.                               */
+/*                                                                      */
+/************************************************************************/
+
+/*
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+ */
+
+/************************************************************************/
+/*  Module Description:                                                 */
+/*                                                                      */
+/* This driver runs timer 0 of an AXI Timer/Counter in auto reload      */
+/* down count mode and calls a handler from its interrupt at a fixed    */
+/* rate.                                                                */
+/*                                                                      */
+/************************************************************************/
+
+#include "control_timer.h"
+
+static void CONTROL_TIMER_interrupt_handler(void* callbackRef, u8 timerNumber);
+
+/**
+ * long CONTROL_TIMER_init(ControlTimer* controlTimer, u16 deviceID,
+ *      XTmrCtr* timer, u32 clockFreqHz, u32 rateHz,
+ *      ControlTimerHandler handler, void* callbackRef)
+ *
+ * @details initialize the driver, the timer is left stopped
+ *
+ * @param controlTimer        Control timer with actual state reference
+ * @param deviceID            AXI Device ID
+ * @param timer               AXI Timer Counter reference
+ * @param clockFreqHz         AXI Timer Counter clock frequency
+ * @param rateHz              tick rate in Hz
+ * @param handler             function called on every tick
+ * @param callbackRef         argument passed to the handler
+ * @return XST_SUCCESS or XST_FAILURE
+ */
+long CONTROL_TIMER_init(ControlTimer* controlTimer, u16 deviceID,
+        XTmrCtr* timer, u32 clockFreqHz, u32 rateHz,
+        ControlTimerHandler handler, void* callbackRef) {
+
+    int status;
+    controlTimer->deviceID = deviceID;
+    controlTimer->timer = timer;
+    controlTimer->rateHz = rateHz;
+    controlTimer->handler = handler;
+    controlTimer->callbackRef = callbackRef;
+    controlTimer->ticks = 0;
+
+    status = XTmrCtr_Initialize(controlTimer->timer, controlTimer->deviceID);
+    if (status != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+
+    XTmrCtr_SetHandler(controlTimer->timer, CONTROL_TIMER_interrupt_handler,
+            controlTimer);
+    XTmrCtr_SetOptions(controlTimer->timer, 0,
+            XTC_INT_MODE_OPTION | XTC_AUTO_RELOAD_OPTION
+                    | XTC_DOWN_COUNT_OPTION);
+    /* In down count generate mode the period is (load value + 2) clocks */
+    XTmrCtr_SetResetValue(controlTimer->timer, 0, clockFreqHz / rateHz - 2);
+    return XST_SUCCESS;
+}
+
+/**
+ * long CONTROL_TIMER_connect(ControlTimer* controlTimer, XIntc* intc,
+ *      u8 interruptID)
+ *
+ * @details connect the timer interrupt to the interrupt controller
+ *
+ * @param controlTimer      Control timer with actual state
+ * @param intc              initialized interrupt controller
+ * @param interruptID       interrupt ID of the timer in the controller
+ * @return XST_SUCCESS or XST_FAILURE
+ */
+long CONTROL_TIMER_connect(ControlTimer* controlTimer, XIntc* intc,
+        u8 interruptID) {
+    int status;
+    status = XIntc_Connect(intc, interruptID,
+            (XInterruptHandler) XTmrCtr_InterruptHandler, controlTimer->timer);
+    if (status != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+    XIntc_Enable(intc, interruptID);
+    return XST_SUCCESS;
+}
+
+/**
+ * void CONTROL_TIMER_start(ControlTimer* controlTimer)
+ *
+ * @details Start ticking
+ *
+ * @param controlTimer      Control timer with actual state
+ */
+void CONTROL_TIMER_start(ControlTimer* controlTimer) {
+    XTmrCtr_Start(controlTimer->timer, 0);
+}
+
+/**
+ * void CONTROL_TIMER_stop(ControlTimer* controlTimer)
+ *
+ * @details Stop ticking
+ *
+ * @param controlTimer      Control timer with actual state
+ */
+void CONTROL_TIMER_stop(ControlTimer* controlTimer) {
+    XTmrCtr_Stop(controlTimer->timer, 0);
+}
+
+/**
+ * u32 CONTROL_TIMER_get_ticks(ControlTimer* controlTimer)
+ *
+ * @details returns the number of ticks since the timer was initialized
+ *
+ * @param controlTimer      Control timer with actual state
+ * @return  ticks since initialization
+ */
+u32 CONTROL_TIMER_get_ticks(ControlTimer* controlTimer) {
+    return controlTimer->ticks;
+}
+
+/**
+ * Called by the XTmrCtr interrupt handler on every timer expiration
+ */
+static void CONTROL_TIMER_interrupt_handler(void* callbackRef, u8 timerNumber) {
+    ControlTimer* controlTimer = (ControlTimer*) callbackRef;
+    controlTimer->ticks++;
+    if (controlTimer->handler) {
+        controlTimer->handler(controlTimer->callbackRef);
+    }
+}
@@ -0,0 +1,62 @@
+/************************************************************************/
+/*                                                                      */
+/*  control_timer.h: Control loop tick timer Header for the Bot.        */
+/*  This driver raises a periodic interrupt at a fixed rate             */
+/*  This file is part of the Arty S7 Bot.                               */
+/*                                                                      */
+/************************************************************************/
+
+/*
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+ */
+
+/************************************************************************/
+/*  Module Description:                                                 */
+/*                                                                      */
+/* This driver runs timer 0 of an AXI Timer/Counter in auto reload      */
+/* down count mode and calls a handler from its interrupt at a fixed    */
+/* rate. The period does not depend on the work done by the handler     */
+/* or by the main loop.                                                 */
+/*                                                                      */
+/*  Call CONTROL_TIMER_init, CONTROL_TIMER_connect and then             */
+/*  CONTROL_TIMER_start                                                 */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef CONTROL_TIMER_H
+#define CONTROL_TIMER_H
+
+#include "xil_types.h"
+#include "xtmrctr.h"
+#include "xintc.h"
+
+// Handler called from the tick interrupt
+typedef void (*ControlTimerHandler)(void* callbackRef);
+
+typedef struct ControlTimer {
+    u16 deviceID;                // AXI device ID
+    XTmrCtr* timer;              // pointer to the XTmrCtr instance
+    u32 rateHz;                  // tick rate in Hz
+    ControlTimerHandler handler; // called on every tick
+    void* callbackRef;           // argument for the handler
+    volatile u32 ticks;          // ticks since start
+} ControlTimer;
+
+long CONTROL_TIMER_init(ControlTimer* controlTimer, u16 deviceID,
+        XTmrCtr* timer, u32 clockFreqHz, u32 rateHz,
+        ControlTimerHandler handler, void* callbackRef);
+long CONTROL_TIMER_connect(ControlTimer* controlTimer, XIntc* intc,
+        u8 interruptID);
+void CONTROL_TIMER_start(ControlTimer* controlTimer);
+void CONTROL_TIMER_stop(ControlTimer* controlTimer);
+u32 CONTROL_TIMER_get_ticks(ControlTimer* controlTimer);
+
+#endif // CONTROL_TIMER_H
@@ -41,28 +41,30 @@
 /**
  * void DISTANCE_PID_CONTROLLER_init(DistancePIDController * controller,
  *         double KProportional, double KIntegral, double KDerivative,
- *         double baseDutyCyclePct)
+ *         double baseDutyCyclePct, u32 periodTicks)
  *
- * Uses a PID controller to compute new duty cycles for motor1 and motor2
- * with goal of maintaining motor speeds at speed target and store them in
- * dutyCyclePct. Assumes that this function gets called at regular time
- * intervals.
+ * Configure a PID controller to compute new duty cycles for motor1 and motor2
+ * with goal of minimizing the position difference.
+ * The gains are given in duty cycle per error unit and stored as Q16.16 PWM
+ * timer ticks, so only the init does floating point.
  *
  * @param controller            Distance PID controller configuration and state
  * @param KProportional         PID proportional term
  * @param KIntegral             PID Integral term
  * @param KDerivative           PID Derivative term
  * @param baseDutyCyclePct      Base duty cycle percentage
+ * @param periodTicks           PWM period in timer ticks
  */
 void DISTANCE_PID_CONTROLLER_init(DistancePIDController * controller,
         double KProportional, double KIntegral, double KDerivative,
-        double baseDutyCyclePct) {
-
-    controller->KProportional = KProportional;
-    controller->KIntegral = KIntegral;
-    controller->KDerivative = KDerivative;
-    controller->baseDutyCyclePct = baseDutyCyclePct;
-
+        double baseDutyCyclePct, u32 periodTicks) {
+
+    controller->periodTicks = periodTicks;
+    PID_CONTROLLER_init(&controller->pid,
+            PID_Q16(KProportional * periodTicks),
+            PID_Q16(KIntegral * periodTicks),
+            PID_Q16(KDerivative * periodTicks), 0, 0);
+    DISTANCE_PID_CONTROLLER_set_duty_cycle(controller, baseDutyCyclePct);
 }
 
 /**
@@ -76,54 +78,38 @@ void DISTANCE_PID_CONTROLLER_init(DistancePIDController * controller,
  */
 void DISTANCE_PID_CONTROLLER_set_duty_cycle(DistancePIDController * controller,
         double baseDutyCyclePct) {
-    controller->baseDutyCyclePct = baseDutyCyclePct;
+    s32 base = baseDutyCyclePct * controller->periodTicks;
+    s32 period = controller->periodTicks;
+    controller->baseDutyTicks = base;
+    // the correction speeds up one motor, up to the period
+    PID_CONTROLLER_set_limits(&controller->pid, base - period, period - base);
 }
 
 /**
  * void DISTANCE_PID_CONTROLLER_get_new_outputs(
- *      DistancePIDController * controller, int pos_diff, double dutyCyclePct[])
+ *      DistancePIDController * controller, int pos_diff, u32 dutyTicks[])
  *
  *  Uses a PID controller to compute new duty cycles for the right motor and the left motor
- *  with goal of minimizing position difference to 0 and store them in duty_cycle.
+ *  with goal of minimizing position difference to 0 and store them in dutyTicks.
  *  Assumes that this function gets called at regular time intervals
  *
  * @param controller        Distance PID controller configuration and state
  * @param pos_diff
- * @param dutyCyclePct      returns base duty cycle values (from 0.0 to 1.0)
- *                          for right and left motors
+ * @param dutyTicks         returns duty cycles in PWM timer ticks (from 0 to
+ *                          the period) for right and left motors
  */
 void DISTANCE_PID_CONTROLLER_get_new_outputs(
-        DistancePIDController * controller, int pos_diff, double dutyCyclePct[]) {
+        DistancePIDController * controller, int pos_diff, u32 dutyTicks[]) {
 
-    controller->accumulated_error += pos_diff;
+    s32 correction = PID_CONTROLLER_update(&controller->pid, pos_diff);
 
-    double correction = controller->KProportional * pos_diff
-            + controller->KIntegral * controller->accumulated_error
-            + controller->KDerivative * (pos_diff - controller->previous_error);
-
-    dutyCyclePct[0] = controller->baseDutyCyclePct;
-    dutyCyclePct[1] = controller->baseDutyCyclePct;
+    dutyTicks[0] = controller->baseDutyTicks;
+    dutyTicks[1] = controller->baseDutyTicks;
     if (correction < 0) {
-        dutyCyclePct[0] -= correction; // Motor1 lagging, speed up
+        dutyTicks[0] -= correction; // Motor1 lagging, speed up
     } else {
-        dutyCyclePct[1] += correction; // Motor2 lagging, speed up
-    }
-
-    controller->previous_error = pos_diff;
-
-    // Bound duty cycles between 0 and 1
-    if (dutyCyclePct[0] < 0.0) {
-        dutyCyclePct[0] = 0.0;
-    } else if (dutyCyclePct[0] > 1.0) {
-        dutyCyclePct[0] = 1.0;
+        dutyTicks[1] += correction; // Motor2 lagging, speed up
     }
-
-    if (dutyCyclePct[1] < 0.0) {
-        dutyCyclePct[1] = 0.0;
-    } else if (dutyCyclePct[1] > 1.0) {
-        dutyCyclePct[1] = 1.0;
-    }
-
 }
 
 /**
@@ -134,6 +120,5 @@ void DISTANCE_PID_CONTROLLER_get_new_outputs(
  * @param controller    Distance PID controller configuration and state
  */
 void DISTANCE_PID_CONTROLLER_reset_errors(DistancePIDController * controller) {
-    controller->accumulated_error = 0;
-    controller->previous_error = 0;
+    PID_CONTROLLER_reset_errors(&controller->pid);
 }
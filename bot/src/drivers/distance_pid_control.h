@@ -52,23 +52,22 @@
 #ifndef DISTANCE_PID_CONTROLLER_H
 #define DISTANCE_PID_CONTROLLER_H
 
+#include "pid_controller.h"
+
 typedef struct DistancePIDController {
-    double KProportional;
-    double KIntegral;
-    double KDerivative;
-    int accumulated_error;
-    int previous_error;
-    double baseDutyCyclePct;
+    PIDController pid;
+    u32 baseDutyTicks;
+    u32 periodTicks;
 } DistancePIDController;
 
 /************ Function Prototypes ************/
 
 void DISTANCE_PID_CONTROLLER_init(DistancePIDController * controller,
         double KProportional, double KIntegral, double KDerivative,
-        double baseDutyCyclePct);
+        double baseDutyCyclePct, u32 periodTicks);
 
 void DISTANCE_PID_CONTROLLER_get_new_outputs(
-        DistancePIDController * controller, int pos_diff, double duty_cycle[]);
+        DistancePIDController * controller, int pos_diff, u32 dutyTicks[]);
 
 void DISTANCE_PID_CONTROLLER_reset_errors(DistancePIDController * controller);
 
@@ -29,6 +29,11 @@
 /*                                                                      */
 /*  Call BOT_DRIVER_init for initializing the driver                    */
 /*                                                                      */
+/*  The motion functions set the target of a motion and wait while     */
+/*  DRIVING_DRIVER_control_tick, called from a timer interrupt at a     */
+/*  fixed rate, runs the PID controllers and stops the motors when the  */
+/*  target is reached.                                                  */
+/*                                                                      */
 /*  DRIVING_DRIVER_drive_forward_cm :                                   */
 /*    Drive forward by given distance (cm), then come to complete stop. */
 /*                                                                      */
@@ -88,10 +93,18 @@
 #include "pwm_driver.h"
 #include "sleep.h"
 #include "distance_pid_control.h"
+#include "mb_interface.h"
 
 /************ Macro Definitions ************/
 
-#define SAMPLE_PER 25000 // 25 ms => 40 Hz sample frequency
+#define STOPPED_SAMPLES 3 // speed loop samples at 0 rpm for a stop
+
+#define QUEUE_MASK (DRIVING_DRIVER_QUEUE_SIZE - 1)
+
+#define MSR_IE_MASK 0x2 // MicroBlaze MSR interrupt enable bit
+
+#define TURN_RPM        25 // cruise wheel speed of turns
+#define SWING_TURN_RPM  30 // cruise wheel speed of swing turns
 
 #define FULL_TURN_ARCLENGTH       3.141 * 15.0
 #define FULL_SWING_TURN_ARCLENGTH 3.141 * 15.0 * 2
@@ -113,6 +126,39 @@ void enableMotors(DrivingDriver* driver);
 void disableMotors(DrivingDriver* driver);
 void resetErrors(DrivingDriver* driver);
 
+static void distanceTick(DrivingDriver* driver);
+static void turnTick(DrivingDriver* driver);
+static void swingTurnTick(DrivingDriver* driver);
+static void lightTick(DrivingDriver* driver);
+static void waitStopTick(DrivingDriver* driver);
+static void startCommand(DrivingDriver* driver);
+static void endCommand(DrivingDriver* driver, MotionStatus status);
+static u32 queueCommand(DrivingDriver* driver, MotionCommandType type,
+        double value);
+static void runCommand(DrivingDriver* driver, MotionCommandType type,
+        double value);
+static u32 lockControlTick(void);
+static void unlockControlTick(u32 msr);
+static int speedLoopDue(DrivingDriver* driver);
+static void startMotion(DrivingDriver* driver, MotionMode mode);
+static void startSegment(DrivingDriver* driver);
+static void startDistanceDutyCycles(DrivingDriver* driver);
+static void addSpeedDutyCycles(DrivingDriver* driver);
+static void updatePose(DrivingDriver* driver);
+static void getSegmentPositions(DrivingDriver* driver, s32 positions[]);
+static s32 getSegmentPositionDifference(DrivingDriver* driver);
+static s32 getSegmentDistance(DrivingDriver* driver);
+static void finishMotion(DrivingDriver* driver);
+static void applyDutyCycles(DrivingDriver* driver);
+static void applySwingDutyCycle(DrivingDriver* driver);
+static int obstacleDistanceMm(void);
+static MoveDirection commandDirection(MotionCommandType type);
+static void setDirection(DrivingDriver* driver, MoveDirection direction);
+static void startDrive(DrivingDriver* driver, s32 targetEdges);
+static void startTurn(DrivingDriver* driver, s32 targetEdges);
+static void startSwingTurn(DrivingDriver* driver, s32 targetEdges,
+        TurnDirection dir);
+
 void DRIVING_DRIVER_drive_light(DrivingDriver* driver, double distance_cm,
         u16 lightTarget);
 
@@ -161,6 +207,18 @@ void DRIVING_DRIVER_init(DrivingDriver* driver, MotorPosition* motorPosition,
     driver->distanceCmCorrection = distanceCmCorrection;
     driver->distanceArcCmCorrection = distanceArcCmCorrection;
     driver->colorSensor = colorSensor;
+    driver->motionMode = MOTION_IDLE;
+    driver->speedLoopDivider = 1;
+    driver->speedLoopCount = 0;
+    driver->directionSettling = 0;
+    driver->queueHead = 0;
+    driver->queueTail = 0;
+    driver->lastCommandId = 0;
+    driver->activeCommandId = 0;
+    driver->completedCommandId = 0;
+    driver->motionCallback = NULL;
+    driver->motionCallbackRef = NULL;
+    driver->poseEstimator = NULL;
 
     if (driver->sensorsConfiguration == FRONT_SENSORS) {
         HBRIDGE_DRIVER_set_direction(driver->hbridge, DIRECT_DIRECTION);
@@ -168,7 +226,7 @@ void DRIVING_DRIVER_init(DrivingDriver* driver, MotorPosition* motorPosition,
         HBRIDGE_DRIVER_set_direction(driver->hbridge, REVERSE_DIRECTION);
     }
 
-    MOTOR_POSITION_clear_pos_counter(driver->motorPosition);
+    startSegment(driver);
     MOTOR_POSITION_clear_speed_counters(driver->motorPosition);
 
     PWM_DRIVER_set_period_ns(driver->pwmRightMotor, pwmPeriod_ns);
@@ -179,8 +237,51 @@ void DRIVING_DRIVER_init(DrivingDriver* driver, MotorPosition* motorPosition,
 
     DRIVING_DRIVER_set_speed(driver, baseDutyCycle);
 
-    driver->previousPositionDifference = MOTOR_POSITION_get_position_difference(
-            driver->motorPosition);
+    driver->previousPositionDifference = getSegmentPositionDifference(driver);
+}
+
+/**
+ * void DRIVING_DRIVER_set_control_rate(DrivingDriver* driver, u32 controlRateHz,
+ *         u32 speedLoopRateHz)
+ *
+ * @details Set the rate DRIVING_DRIVER_control_tick is called at. The speed and
+ *      light controllers run at speedLoopRateHz, the rate their gains are
+ *      tuned for
+ *
+ * @param driver            Driving driver to use with its actual state
+ * @param controlRateHz     control tick rate in Hz
+ * @param speedLoopRateHz   speed and light controllers rate in Hz
+ */
+void DRIVING_DRIVER_set_control_rate(DrivingDriver* driver, u32 controlRateHz,
+        u32 speedLoopRateHz) {
+    driver->controlRateHz = controlRateHz;
+    driver->speedLoopDivider = controlRateHz / speedLoopRateHz;
+    if (driver->speedLoopDivider == 0) {
+        driver->speedLoopDivider = 1;
+    }
+    driver->speedLoopCount = 0;
+}
+
+/**
+ * void DRIVING_DRIVER_set_motion_profile(DrivingDriver* driver, u32 driveRpm,
+ *         u32 accelerationRpmPerS, u32 minRpm)
+ *
+ * @details Set the velocity profile of moves and turns. Moves start at
+ *      minRpm, accelerate up to their cruise speed and decelerate back to
+ *      minRpm at the target. Call after DRIVING_DRIVER_set_control_rate
+ *
+ * @param driver                Driving driver to use with its actual state
+ * @param driveRpm              cruise wheel speed of straight moves
+ * @param accelerationRpmPerS   wheel acceleration and deceleration
+ * @param minRpm                wheel speed at start and end of moves
+ */
+void DRIVING_DRIVER_set_motion_profile(DrivingDriver* driver, u32 driveRpm,
+        u32 accelerationRpmPerS, u32 minRpm) {
+    driver->driveRpm = driveRpm;
+    MOTION_PROFILE_init(&driver->profile,
+            driver->motorPosition->edgesPerRev
+                    * driver->motorPosition->gearboxRatio,
+            driver->controlRateHz, accelerationRpmPerS, minRpm);
 }
 
 void DRIVING_DRIVER_set_light_pid_controller(DrivingDriver* driver,
@@ -211,7 +312,7 @@ void DRIVING_DRIVER_set_speed(DrivingDriver * driver, double baseDutyCycle) {
  * @param driver         Driving driver to use with its actual state
  */
 void DRIVING_DRIVER_end(DrivingDriver* driver) {
-    disableMotors(driver);
+    DRIVING_DRIVER_cancel_commands(driver);
     DRIVING_DRIVER_set_direction_forward(driver);
 
 }
@@ -283,8 +384,7 @@ void DRIVING_DRIVER_turn_right_degrees(DrivingDriver* driver, int degrees) {
  */
 void DRIVING_DRIVER_drive_forward_continuous_cm(DrivingDriver* driver,
         double distanceCm) {
-    DRIVING_DRIVER_set_direction_forward(driver);
-    DRIVING_DRIVER_drive_cm(driver, distanceCm);
+    runCommand(driver, MOTION_CMD_FORWARD, distanceCm);
 }
 
 /**
@@ -300,8 +400,7 @@ void DRIVING_DRIVER_drive_forward_continuous_cm(DrivingDriver* driver,
  */
 void DRIVING_DRIVER_drive_backward_continuous_cm(DrivingDriver* driver,
         double distanceCm) {
-    DRIVING_DRIVER_set_direction_backward(driver);
-    DRIVING_DRIVER_drive_cm(driver, distanceCm);
+    runCommand(driver, MOTION_CMD_BACKWARD, distanceCm);
 }
 
 /**
@@ -317,9 +416,7 @@ void DRIVING_DRIVER_drive_backward_continuous_cm(DrivingDriver* driver,
  */
 void DRIVING_DRIVER_turn_left_continuous_degrees(DrivingDriver* driver,
         int degrees) {
-    double arclength = FULL_TURN_ARCLENGTH * (degrees / 360.0);
-    DRIVING_DRIVER_set_direction_left(driver);
-    DRIVING_DRIVER_turn(driver, arclength);
+    runCommand(driver, MOTION_CMD_TURN_LEFT, degrees);
 }
 
 /**
@@ -335,10 +432,7 @@ void DRIVING_DRIVER_turn_left_continuous_degrees(DrivingDriver* driver,
  */
 void DRIVING_DRIVER_turn_right_continuous_degrees(DrivingDriver* driver,
         int degrees) {
-    double arclength = FULL_TURN_ARCLENGTH * (degrees / 360.0);
-    DRIVING_DRIVER_set_direction_right(driver);
-
-    DRIVING_DRIVER_turn(driver, arclength);
+    runCommand(driver, MOTION_CMD_TURN_RIGHT, degrees);
 }
 
 /**
@@ -350,9 +444,7 @@ void DRIVING_DRIVER_turn_right_continuous_degrees(DrivingDriver* driver,
  * @param degrees           Angle in degrees to left turn the Bot
  */
 void DRIVING_DRIVER_swing_turn_left_degrees(DrivingDriver* driver, int degrees) {
-    double arclength = FULL_SWING_TURN_ARCLENGTH * (degrees / 360.0);
-    DRIVING_DRIVER_set_direction_left(driver);
-    DRIVING_DRIVER_swing_turn(driver, arclength, LEFT);
+    runCommand(driver, MOTION_CMD_SWING_TURN_LEFT, degrees);
     DRIVING_DRIVER_delay_until_stop(driver);
 }
 
@@ -365,281 +457,920 @@ void DRIVING_DRIVER_swing_turn_left_degrees(DrivingDriver* driver, int degrees)
  * @param degrees           Angle in degrees to right turn the Bot
  */
 void DRIVING_DRIVER_swing_turn_right_degrees(DrivingDriver* driver, int degrees) {
-    double arclength = FULL_SWING_TURN_ARCLENGTH * (degrees / 360.0);
-    DRIVING_DRIVER_set_direction_right(driver);
-    DRIVING_DRIVER_swing_turn(driver, arclength, RIGHT);
+    runCommand(driver, MOTION_CMD_SWING_TURN_RIGHT, degrees);
     DRIVING_DRIVER_delay_until_stop(driver);
 }
 
 /**
  * void DRIVING_DRIVER_set_direction_forward(DrivingDriver* driver)
  *
- * @details Set motor directions to forward and reset position counters
+ * @details Set motor directions to forward and start a new segment from the
+ *      current odometry, the position counters are never cleared
  *
  * @param driver           Driving driver to use with its actual state
  */
 void DRIVING_DRIVER_set_direction_forward(DrivingDriver* driver) {
-    driver->previousDirection = driver->direction;
     if (driver->direction != FORWARD) {
         disableMotors(driver);
         usleep(6);
-        HBRIDGE_DRIVER_left_motor_forward(driver->hbridge);
-        HBRIDGE_DRIVER_right_motor_forward(driver->hbridge);
-        resetErrors(driver);
-        driver->direction = FORWARD;
     }
-    MOTOR_POSITION_clear_pos_counter(driver->motorPosition);
+    setDirection(driver, FORWARD);
 }
 
 /**
  * void DRIVING_DRIVER_set_direction_backward(DrivingDriver* driver)
  *
- * @details Set motor directions to backward and reset position counters
+ * @details Set motor directions to backward and start a new segment from the
+ *      current odometry, the position counters are never cleared
  *
  * @param driver           Driving driver to use with its actual state
  */
 void DRIVING_DRIVER_set_direction_backward(DrivingDriver* driver) {
-    driver->previousDirection = driver->direction;
     if (driver->direction != BACKWARD) {
         disableMotors(driver);
         usleep(6);
-        HBRIDGE_DRIVER_left_motor_backward(driver->hbridge);
-        HBRIDGE_DRIVER_right_motor_backward(driver->hbridge);
-        resetErrors(driver);
-        driver->direction = BACKWARD;
     }
-    MOTOR_POSITION_clear_pos_counter(driver->motorPosition);
+    setDirection(driver, BACKWARD);
 }
 
 /**
  * void DRIVING_DRIVER_set_direction_left(DrivingDriver* driver) *
  *
  * @details Set motor directions for left turn (left motor backward,
- *      right motor forward) and reset position counters
+ *      right motor forward) and start a new segment from the current
+ *      odometry, the position counters are never cleared
  *
  * @param driver            Driving driver to use with its actual state
  */
 void DRIVING_DRIVER_set_direction_left(DrivingDriver* driver) {
-    driver->previousDirection = driver->direction;
     disableMotors(driver);
     usleep(6);
-    HBRIDGE_DRIVER_left_motor_backward(driver->hbridge);
-    HBRIDGE_DRIVER_right_motor_forward(driver->hbridge);
-    resetErrors(driver);
-    driver->direction = TURN_LEFT;
-    MOTOR_POSITION_clear_pos_counter(driver->motorPosition);
-    MOTOR_POSITION_clear_speed_counters(driver->motorPosition);
+    setDirection(driver, TURN_LEFT);
 }
 
 /**
  * void DRIVING_DRIVER_set_direction_right(DrivingDriver* driver)
  *
  * @details Set motor directions for right turn (left motor forward, right motor
- *      backward) and reset position counters
+ *      backward) and start a new segment from the current odometry, the
+ *      position counters are never cleared
  *
  * @param driver           Driving driver to use with its actual state
  */
 void DRIVING_DRIVER_set_direction_right(DrivingDriver* driver) {
-    driver->previousDirection = driver->direction;
     disableMotors(driver);
     usleep(6);
-    HBRIDGE_DRIVER_left_motor_forward(driver->hbridge);
-    HBRIDGE_DRIVER_right_motor_backward(driver->hbridge);
-    resetErrors(driver);
-    driver->direction = TURN_RIGHT;
-    MOTOR_POSITION_clear_pos_counter(driver->motorPosition);
-    MOTOR_POSITION_clear_speed_counters(driver->motorPosition);
+    setDirection(driver, TURN_RIGHT);
 }
 
 /**
  * void DRIVING_DRIVER_drive_cm(DrivingDriver* driver, double distance_cm)
  *
- * @details Drive motors given distance using positional control (motors will have
- *       turned about the same amount at the end)
+ * @details Start driving motors given distance using positional control (motors
+ *       will have turned about the same amount at the end). The wheel speeds
+ *       follow the velocity profile. The control tick stops the motors
  *
  * @param driver            Driving driver to use with its actual state
  * @param distance_cm       Distance in cm to drive the Bot
  */
 void DRIVING_DRIVER_drive_cm(DrivingDriver* driver, double distance_cm) {
-    int16_t dist_converted = (int16_t) (distance_cm
-            * driver->distanceCmCorrection); // TODO cm to sensed edges
+    startDrive(driver, DRIVING_DRIVER_command_target_edges(driver,
+            MOTION_CMD_FORWARD, distance_cm));
+}
+
+/**
+ * DRIVING_DRIVER_turn(DrivingDriver* driver, double arclength)
+ *
+ * @details Start driving motors given arclength using speed control (motors will
+ *       turn at same rate throughout the turn). The control tick stops the motors
+ *
+ * @param driver        Driving driver to use with its actual state
+ * @param arclength     Length of arc in cm for wheels to follow during turn
+ */
+void DRIVING_DRIVER_turn(DrivingDriver* driver, double arclength) {
+    startTurn(driver, (s32) (arclength * driver->distanceArcCmCorrection));
+}
+
+/**
+ * void BOT_DRIVER_swing_turn(BotDriver* driver, double arclength, int dir)
+ *
+ * @details Start driving one motor (determined by dir parameter) the given
+ *       arclength using speed control (motor will turn at constant rate
+ *       throughout the turn). The control tick stops the motor
+ *
+ * @param driver            Driving driver to use with its actual state
+ * @param arclength         Length of arc in cm for wheels to follow during turn
+ * @param dir               Direction of turn LEFT, RIGHT
+ */
+void DRIVING_DRIVER_swing_turn(DrivingDriver* driver, double arclength,
+        TurnDirection dir) {
+    startSwingTurn(driver, (s32) (arclength * driver->distanceArcCmCorrection),
+            dir);
+}
+
+/**
+ * Start a straight move of targetEdges, integer only
+ */
+static void startDrive(DrivingDriver* driver, s32 targetEdges) {
+    driver->targetEdges = targetEdges;
 
-    int16_t pos_diff = MOTOR_POSITION_get_position_difference(
-            driver->motorPosition);
-    double duty_cycle[2];
+    s32 pos_diff = getSegmentPositionDifference(driver);
     if (driver->direction == driver->previousDirection) {
         DISTANCE_PID_CONTROLLER_get_new_outputs(driver->distancePIDController,
-                driver->previousPositionDifference, duty_cycle);
+                driver->previousPositionDifference, driver->dutyTicks);
     } else {
         DISTANCE_PID_CONTROLLER_get_new_outputs(driver->distancePIDController,
-                pos_diff, duty_cycle);
+                pos_diff, driver->dutyTicks);
     }
+    startDistanceDutyCycles(driver);
 
-    int16_t dist_traveled = MOTOR_POSITION_get_distance_traveled(
-            driver->motorPosition);
+    applyDutyCycles(driver);
 
-    disableMotors(driver);
+    startMotion(driver, MOTION_DISTANCE);
+}
 
-    PWM_DRIVER_set_duty_pct(driver->pwmRightMotor, duty_cycle[RIGHT_MOTOR]);
-    PWM_DRIVER_set_duty_pct(driver->pwmLeftMotor, duty_cycle[LEFT_MOTOR]);
+/**
+ * Start a turn about the center of targetEdges on each wheel, integer only
+ */
+static void startTurn(DrivingDriver* driver, s32 targetEdges) {
+    driver->targetEdges = targetEdges;
+    driver->speedTargetRpm = MOTION_PROFILE_start(&driver->profile, TURN_RPM);
 
-    enableMotors(driver);
+    int motor_speed[2];
+    MOTOR_POSITION_get_speeds(driver->motorPosition, motor_speed);
 
-    while (dist_traveled < dist_converted) {
-        usleep(SAMPLE_PER);
-        pos_diff = MOTOR_POSITION_get_position_difference(
-                driver->motorPosition);
+    SPEED_PID_CONTROLLER_get_new_outputs(driver->speedPIDController,
+            driver->speedTargetRpm, motor_speed, driver->dutyTicks);
 
-        DISTANCE_PID_CONTROLLER_get_new_outputs(driver->distancePIDController,
-                pos_diff, duty_cycle);
+    applyDutyCycles(driver);
 
-        disableMotors(driver);
+    startMotion(driver, MOTION_TURN);
+}
 
-        PWM_DRIVER_set_duty_pct(driver->pwmRightMotor, duty_cycle[RIGHT_MOTOR]);
-        PWM_DRIVER_set_duty_pct(driver->pwmLeftMotor, duty_cycle[LEFT_MOTOR]);
+/**
+ * Start a swing turn of targetEdges on the wheel given by dir, integer only
+ */
+static void startSwingTurn(DrivingDriver* driver, s32 targetEdges,
+        TurnDirection dir) {
+    driver->targetEdges = targetEdges;
+    driver->speedTargetRpm = MOTION_PROFILE_start(&driver->profile,
+            SWING_TURN_RPM);
+    driver->swingDirection = dir;
 
-        enableMotors(driver);
+    int motor_speed[2];
+    MOTOR_POSITION_get_speeds(driver->motorPosition, motor_speed);
 
-        dist_traveled = MOTOR_POSITION_get_distance_traveled(
-                driver->motorPosition);
+    SPEED_PID_CONTROLLER_get_new_outputs(driver->speedPIDController,
+            driver->speedTargetRpm, motor_speed, driver->dutyTicks);
 
-    }
+    applySwingDutyCycle(driver);
 
-    driver->previousPositionDifference = pos_diff;
+    startMotion(driver, MOTION_SWING_TURN);
+}
 
-    disableMotors(driver);
+/**
+ * void DRIVING_DRIVER_control_tick(void* callbackRef)
+ *
+ * @details Run one step of the motion in progress. Called from the control
+ *      timer interrupt at the rate given to DRIVING_DRIVER_set_control_rate.
+ *      The end of the motion is checked on every tick, the speed and light
+ *      controllers run every speedLoopDivider ticks. When no motion is in
+ *      progress the next queued command is started.
+ *
+ * @param callbackRef       Driving driver to use with its actual state
+ */
+void DRIVING_DRIVER_control_tick(void* callbackRef) {
+    DrivingDriver* driver = (DrivingDriver*) callbackRef;
+
+    MOTOR_POSITION_update_odometry(driver->motorPosition);
+    updatePose(driver);
+
+    switch (driver->motionMode) {
+    case MOTION_DISTANCE:
+        distanceTick(driver);
+        break;
+    case MOTION_TURN:
+        turnTick(driver);
+        break;
+    case MOTION_SWING_TURN:
+        swingTurnTick(driver);
+        break;
+    case MOTION_LIGHT:
+        lightTick(driver);
+        break;
+    case MOTION_WAIT_STOP:
+        waitStopTick(driver);
+        break;
+    default:
+        break;
+    }
 
+    if (driver->motionMode == MOTION_IDLE) {
+        if (driver->activeCommandId) {
+            endCommand(driver, MOTION_DONE);
+        }
+        if (driver->queueHead != driver->queueTail) {
+            startCommand(driver);
+        }
+    }
 }
 
 /**
- * DRIVING_DRIVER_turn(DrivingDriver* driver, double arclength)
+ * u32 DRIVING_DRIVER_queue_command(DrivingDriver* driver,
+ *         MotionCommandType type, double value)
  *
- * @details Drive motors given arclength using speed control (motors will turn at
- *       same rate throughout the turn)
+ * @details Add a command to the motion queue and return at once. Commands run
+ *      in order, the control tick starts each one when the previous ends.
+ *      The value is converted to edges here with floating point: call it from
+ *      the main loop only, use DRIVING_DRIVER_queue_command_edges from the
+ *      motion callback
  *
- * @param driver        Driving driver to use with its actual state
- * @param arclength     Length of arc in cm for wheels to follow during turn
+ * @param driver            Driving driver to use with its actual state
+ * @param type              command to run
+ * @param value             distance in cm or angle in degrees, see MotionCommandType
+ * @return  id of the command, 0 if the queue is full
  */
-void DRIVING_DRIVER_turn(DrivingDriver* driver, double arclength) {
-    int16_t dist_converted = (int16_t) (arclength
-            * driver->distanceArcCmCorrection); // cm to sens edges
+u32 DRIVING_DRIVER_queue_command(DrivingDriver* driver, MotionCommandType type,
+        double value) {
+    return DRIVING_DRIVER_queue_command_edges(driver, type,
+            DRIVING_DRIVER_command_target_edges(driver, type, value));
+}
 
-    int motor_speed[2];
-    MOTOR_POSITION_get_speeds(driver->motorPosition, motor_speed);
+/**
+ * u32 DRIVING_DRIVER_queue_command_edges(DrivingDriver* driver,
+ *         MotionCommandType type, s32 targetEdges)
+ *
+ * @details Add a command to the motion queue with its target already in
+ *      edges. Integer only, can be called from any context including the
+ *      motion callback
+ *
+ * @param driver            Driving driver to use with its actual state
+ * @param type              command to run
+ * @param targetEdges       target from DRIVING_DRIVER_command_target_edges
+ * @return  id of the command, 0 if the queue is full
+ */
+u32 DRIVING_DRIVER_queue_command_edges(DrivingDriver* driver,
+        MotionCommandType type, s32 targetEdges) {
+    u32 id = 0;
+    u32 msr = lockControlTick();
+
+    if (driver->queueHead - driver->queueTail < DRIVING_DRIVER_QUEUE_SIZE) {
+        id = ++driver->lastCommandId;
+        if (id == 0) {
+            id = ++driver->lastCommandId;
+        }
+        MotionCommand* command = &driver->queue[driver->queueHead & QUEUE_MASK];
+        command->type = type;
+        command->targetEdges = targetEdges;
+        command->id = id;
+        driver->queueHead++;
+    }
 
-    int16_t motor_position[2];
-    MOTOR_POSITION_get_positions(driver->motorPosition, motor_position);
+    unlockControlTick(msr);
+    return id;
+}
 
-    double duty_cycle[2];
-    int speedTarget = 25;
+/**
+ * s32 DRIVING_DRIVER_command_target_edges(DrivingDriver* driver,
+ *         MotionCommandType type, double value)
+ *
+ * @details Convert a command value to its target in edges with floating
+ *      point, in the main loop. Commands queued from the motion callback
+ *      use targets converted beforehand
+ *
+ * @param driver            Driving driver to use with its actual state
+ * @param type              command the value is for
+ * @param value             distance in cm or angle in degrees, see MotionCommandType
+ * @return  target in edges
+ */
+s32 DRIVING_DRIVER_command_target_edges(DrivingDriver* driver,
+        MotionCommandType type, double value) {
+    switch (type) {
+    case MOTION_CMD_FORWARD:
+    case MOTION_CMD_BACKWARD:
+        return (s32) (value * driver->distanceCmCorrection); // TODO cm to sensed edges
+    case MOTION_CMD_TURN_LEFT:
+    case MOTION_CMD_TURN_RIGHT:
+        return (s32) (FULL_TURN_ARCLENGTH * (value / 360.0)
+                * driver->distanceArcCmCorrection);
+    case MOTION_CMD_SWING_TURN_LEFT:
+    case MOTION_CMD_SWING_TURN_RIGHT:
+        return (s32) (FULL_SWING_TURN_ARCLENGTH * (value / 360.0)
+                * driver->distanceArcCmCorrection);
+    default:
+        return 0;
+    }
+}
 
-    SPEED_PID_CONTROLLER_get_new_outputs(driver->speedPIDController,
-            speedTarget, motor_speed, duty_cycle);
+/**
+ * int DRIVING_DRIVER_command_done(DrivingDriver* driver, u32 commandId)
+ *
+ * @details Check if a queued command has ended, done or canceled
+ *
+ * @param driver            Driving driver to use with its actual state
+ * @param commandId         id returned by DRIVING_DRIVER_queue_command
+ * @return  1 if the command has ended, 0 if it is queued or running
+ */
+int DRIVING_DRIVER_command_done(DrivingDriver* driver, u32 commandId) {
+    return (s32) (driver->completedCommandId - commandId) >= 0;
+}
 
-    enableMotors(driver);
+/**
+ * int DRIVING_DRIVER_is_idle(DrivingDriver* driver)
+ *
+ * @details Check if there is no motion in progress and no command queued
+ *
+ * @param driver            Driving driver to use with its actual state
+ * @return  1 if idle
+ */
+int DRIVING_DRIVER_is_idle(DrivingDriver* driver) {
+    return driver->motionMode == MOTION_IDLE && driver->activeCommandId == 0
+            && driver->queueHead == driver->queueTail;
+}
 
-    while (motor_position[RIGHT_MOTOR] < dist_converted
-            || motor_position[LEFT_MOTOR] < dist_converted) {
-//        int16_t dist_to_targ = dist_converted
-//                - (motor_position[RIGHT_MOTOR] + motor_position[LEFT_MOTOR]) / 2;
-//        speedTarget = 25;
-//        if (dist_to_targ < 25) {
-//            speedTarget = 12.5 + 0.5 * dist_to_targ;
-//        }
-        usleep(SAMPLE_PER);
-        MOTOR_POSITION_get_speeds(driver->motorPosition, motor_speed);
+/**
+ * void DRIVING_DRIVER_wait_idle(DrivingDriver* driver)
+ *
+ * @details Wait until all queued commands have ended
+ *
+ * @param driver            Driving driver to use with its actual state
+ */
+void DRIVING_DRIVER_wait_idle(DrivingDriver* driver) {
+    while (!DRIVING_DRIVER_is_idle(driver)) {
+    }
+}
 
-        SPEED_PID_CONTROLLER_get_new_outputs(driver->speedPIDController,
-                speedTarget, motor_speed, duty_cycle);
+/**
+ * void DRIVING_DRIVER_cancel_commands(DrivingDriver* driver)
+ *
+ * @details Stop the motors and drop the running and queued commands, they are
+ *      reported as MOTION_CANCELED. Can be called from any context, including
+ *      the motion callback
+ *
+ * @param driver            Driving driver to use with its actual state
+ */
+void DRIVING_DRIVER_cancel_commands(DrivingDriver* driver) {
+    u32 msr = lockControlTick();
 
-        disableMotors(driver);
+    DRIVING_DRIVER_stop_motion(driver);
+    driver->directionSettling = 0;
+    if (driver->activeCommandId) {
+        endCommand(driver, MOTION_CANCELED);
+    }
+    while (driver->queueHead != driver->queueTail) {
+        driver->activeCommandId =
+                driver->queue[driver->queueTail & QUEUE_MASK].id;
+        driver->queueTail++;
+        endCommand(driver, MOTION_CANCELED);
+    }
 
-        if (motor_position[RIGHT_MOTOR] >= dist_converted) {
-            PWM_DRIVER_set_duty_pct(driver->pwmRightMotor, 0.0);
-        } else {
-            PWM_DRIVER_set_duty_pct(driver->pwmRightMotor,
-                    duty_cycle[RIGHT_MOTOR]);
-        }
-        if (motor_position[LEFT_MOTOR] >= dist_converted) {
-            PWM_DRIVER_set_duty_pct(driver->pwmLeftMotor, 0.0);
-        } else {
-            PWM_DRIVER_set_duty_pct(driver->pwmLeftMotor,
-                    duty_cycle[LEFT_MOTOR]);
-        }
+    unlockControlTick(msr);
+}
 
-        enableMotors(driver);
+/**
+ * void DRIVING_DRIVER_set_motion_callback(DrivingDriver* driver,
+ *         MotionCallback callback, void* callbackRef)
+ *
+ * @details Set a function called when each queued command ends. It is called
+ *      from the control tick interrupt, or from DRIVING_DRIVER_cancel_commands
+ *
+ * @param driver            Driving driver to use with its actual state
+ * @param callback          function to call, NULL for none
+ * @param callbackRef       first argument of the callback
+ */
+void DRIVING_DRIVER_set_motion_callback(DrivingDriver* driver,
+        MotionCallback callback, void* callbackRef) {
+    u32 msr = lockControlTick();
+    driver->motionCallback = callback;
+    driver->motionCallbackRef = callbackRef;
+    unlockControlTick(msr);
+}
 
-        MOTOR_POSITION_get_positions(driver->motorPosition, motor_position);
-    }
+/**
+ * void DRIVING_DRIVER_set_pose_estimator(DrivingDriver* driver,
+ *         PoseEstimator* poseEstimator)
+ *
+ * @details Set the estimator the control tick feeds with the wheel motion,
+ *      from now on
+ *
+ * @param driver            Driving driver to use with its actual state
+ * @param poseEstimator     initialized pose estimator, NULL for none
+ */
+void DRIVING_DRIVER_set_pose_estimator(DrivingDriver* driver,
+        PoseEstimator* poseEstimator) {
+    u32 msr = lockControlTick();
+    MOTOR_POSITION_get_odometry(driver->motorPosition, driver->poseEdges);
+    driver->poseEstimator = poseEstimator;
+    unlockControlTick(msr);
+}
 
-    disableMotors(driver);
+/**
+ * void DRIVING_DRIVER_get_pose(DrivingDriver* driver, Pose* pose)
+ *
+ * @details Get the dead reckoning position, heading and velocity of the bot.
+ *      Can be called from any context. Needs a pose estimator, see
+ *      DRIVING_DRIVER_set_pose_estimator
+ *
+ * @param driver            Driving driver to use with its actual state
+ * @param pose              returns the pose
+ */
+void DRIVING_DRIVER_get_pose(DrivingDriver* driver, Pose* pose) {
+    POSE_ESTIMATOR_get_pose(driver->poseEstimator, pose);
 }
 
 /**
- * void BOT_DRIVER_swing_turn(BotDriver* driver, double arclength, int dir)
+ * void DRIVING_DRIVER_set_pose(DrivingDriver* driver, s32 xMm, s32 yMm,
+ *         s32 headingMdeg)
  *
- * @details Drive one motor (determined by dir parameter) the given arclength using
- *       speed control (motor will turn at constant rate throughout the turn)
+ * @details Place the bot at a known pose, the dead reckoning goes on from it
  *
  * @param driver            Driving driver to use with its actual state
- * @param arclength         Length of arc in cm for wheels to follow during turn
- * @param dir               Direction of turn LEFT, RIGHT
+ * @param xMm               x in mm
+ * @param yMm               y in mm
+ * @param headingMdeg       heading in millidegrees, counterclockwise
  */
-void DRIVING_DRIVER_swing_turn(DrivingDriver* driver, double arclength,
-        TurnDirection dir) {
-    int16_t dist_converted = (int16_t) (arclength
-            * driver->distanceArcCmCorrection); // cm to sens edges
+void DRIVING_DRIVER_set_pose(DrivingDriver* driver, s32 xMm, s32 yMm,
+        s32 headingMdeg) {
+    u32 msr = lockControlTick();
+    POSE_ESTIMATOR_set_pose(driver->poseEstimator, xMm, yMm, headingMdeg);
+    unlockControlTick(msr);
+}
 
-    int motor_speed[2];
-    MOTOR_POSITION_get_speeds(driver->motorPosition, motor_speed);
+/**
+ * void DRIVING_DRIVER_stop_motion(DrivingDriver* driver)
+ *
+ * @details Cancel the motion in progress and disable both motors
+ *
+ * @param driver           Driving driver to use with its actual state
+ */
+void DRIVING_DRIVER_stop_motion(DrivingDriver* driver) {
+    driver->motionMode = MOTION_IDLE;
+    disableMotors(driver);
+}
 
-    int16_t motor_position[2];
-    MOTOR_POSITION_get_positions(driver->motorPosition, motor_position);
+/**
+ * Distance control step: keep both wheels together until the distance is
+ * traveled
+ */
+static void distanceTick(DrivingDriver* driver) {
+    s32 pos_diff = getSegmentPositionDifference(driver);
+    s32 distance = getSegmentDistance(driver);
+    driver->previousPositionDifference = pos_diff;
 
-    double duty_cycle[2];
-    int speedTarget = 30;
-    SPEED_PID_CONTROLLER_get_new_outputs(driver->speedPIDController,
-            speedTarget, motor_speed, duty_cycle);
+    if (distance >= driver->targetEdges) {
+        finishMotion(driver);
+        return;
+    }
 
-    if (dir == RIGHT) {
-        PWM_DRIVER_enable(driver->pwmRightMotor);
-        PWM_DRIVER_disable(driver->pwmLeftMotor);
-    } else {
-        PWM_DRIVER_disable(driver->pwmRightMotor);
-        PWM_DRIVER_enable(driver->pwmLeftMotor);
+    driver->speedTargetRpm = MOTION_PROFILE_next(&driver->profile,
+            driver->targetEdges - distance);
+    if (speedLoopDue(driver)) {
+        int motor_speed[2];
+        MOTOR_POSITION_get_speeds(driver->motorPosition, motor_speed);
+        SPEED_PID_CONTROLLER_get_new_outputs(driver->speedPIDController,
+                driver->speedTargetRpm, motor_speed, driver->speedDutyTicks);
     }
 
-    while (motor_position[RIGHT_MOTOR] < dist_converted
-            && motor_position[LEFT_MOTOR] < dist_converted) {
-        usleep(SAMPLE_PER);
+    DISTANCE_PID_CONTROLLER_get_new_outputs(driver->distancePIDController,
+            pos_diff, driver->dutyTicks);
+    addSpeedDutyCycles(driver);
+    applyDutyCycles(driver);
+}
+
+/**
+ * Turn step: speed control on both wheels, each wheel stops at the arc length
+ */
+static void turnTick(DrivingDriver* driver) {
+    s32 motor_position[2];
+    getSegmentPositions(driver, motor_position);
+    int rightDone = motor_position[RIGHT_MOTOR] >= driver->targetEdges;
+    int leftDone = motor_position[LEFT_MOTOR] >= driver->targetEdges;
+
+    if (rightDone && leftDone) {
+        finishMotion(driver);
+        return;
+    }
+
+    driver->speedTargetRpm = MOTION_PROFILE_next(&driver->profile,
+            driver->targetEdges
+                    - (motor_position[RIGHT_MOTOR] + motor_position[LEFT_MOTOR])
+                            / 2);
+    int update = speedLoopDue(driver);
+    if (update) {
+        int motor_speed[2];
         MOTOR_POSITION_get_speeds(driver->motorPosition, motor_speed);
+        SPEED_PID_CONTROLLER_get_new_outputs(driver->speedPIDController,
+                driver->speedTargetRpm, motor_speed, driver->dutyTicks);
+    }
+    if (rightDone && driver->dutyTicks[RIGHT_MOTOR] > 0) {
+        driver->dutyTicks[RIGHT_MOTOR] = 0;
+        update = 1;
+    }
+    if (leftDone && driver->dutyTicks[LEFT_MOTOR] > 0) {
+        driver->dutyTicks[LEFT_MOTOR] = 0;
+        update = 1;
+    }
+    if (update) {
+        applyDutyCycles(driver);
+    }
+}
+
+/**
+ * Swing turn step: speed control on one wheel until it covers the arc length
+ */
+static void swingTurnTick(DrivingDriver* driver) {
+    s32 motor_position[2];
+    getSegmentPositions(driver, motor_position);
+
+    if (motor_position[RIGHT_MOTOR] >= driver->targetEdges
+            || motor_position[LEFT_MOTOR] >= driver->targetEdges) {
+        finishMotion(driver);
+        return;
+    }
 
+    s32 swingPosition = motor_position[RIGHT_MOTOR];
+    if (motor_position[LEFT_MOTOR] > swingPosition) {
+        swingPosition = motor_position[LEFT_MOTOR];
+    }
+    driver->speedTargetRpm = MOTION_PROFILE_next(&driver->profile,
+            driver->targetEdges - swingPosition);
+    if (speedLoopDue(driver)) {
+        int motor_speed[2];
+        MOTOR_POSITION_get_speeds(driver->motorPosition, motor_speed);
         SPEED_PID_CONTROLLER_get_new_outputs(driver->speedPIDController,
-                speedTarget, motor_speed, duty_cycle);
+                driver->speedTargetRpm, motor_speed, driver->dutyTicks);
+        applySwingDutyCycle(driver);
+    }
+}
+
+/**
+ * Light control step: steer on the last light sample until the distance is
+ * traveled
+ */
+static void lightTick(DrivingDriver* driver) {
+    if (getSegmentDistance(driver)
+            >= driver->targetEdges) {
+        finishMotion(driver);
+        return;
+    }
+
+    if (speedLoopDue(driver)) {
+        LIGHT_PID_CONTROLLER_get_new_outputs(driver->lightPIDController,
+                driver->lightDifference, driver->dutyTicks);
+        applyDutyCycles(driver);
+    }
+}
+
+/**
+ * Stop command step: wait for STOPPED_SAMPLES speed samples in a row with
+ * both motors stopped
+ */
+static void waitStopTick(DrivingDriver* driver) {
+    if (!speedLoopDue(driver)) {
+        return;
+    }
+
+    int motor_speed[2];
+    MOTOR_POSITION_get_speeds(driver->motorPosition, motor_speed);
+    if (motor_speed[RIGHT_MOTOR] + motor_speed[LEFT_MOTOR]) {
+        driver->stoppedSamples = 0;
+    } else if (++driver->stoppedSamples >= STOPPED_SAMPLES) {
+        driver->motionMode = MOTION_IDLE;
+    }
+}
 
+/**
+ * Take the next command out of the queue and start its motion. Runs in the
+ * control tick: integer only and no delays. When the H-bridge has to be
+ * reversed the motors are disabled and the command starts on the next tick,
+ * the tick period is the dead time
+ */
+static void startCommand(DrivingDriver* driver) {
+    MotionCommand command = driver->queue[driver->queueTail & QUEUE_MASK];
+    MoveDirection direction = commandDirection(command.type);
+
+    if (direction != IDLE && direction != driver->direction
+            && !driver->directionSettling) {
         disableMotors(driver);
+        driver->directionSettling = 1;
+        return;
+    }
+    driver->directionSettling = 0;
+    driver->queueTail++;
+    driver->activeCommandId = command.id;
+    if (direction != IDLE) {
+        setDirection(driver, direction);
+    }
 
-        if (dir == RIGHT) {
-            PWM_DRIVER_set_duty_pct(driver->pwmRightMotor,
-                    duty_cycle[RIGHT_MOTOR]);
-            PWM_DRIVER_set_duty_pct(driver->pwmLeftMotor, 0.0);
-        } else {
-            PWM_DRIVER_set_duty_pct(driver->pwmRightMotor, 0.0);
-            PWM_DRIVER_set_duty_pct(driver->pwmLeftMotor,
-                    duty_cycle[LEFT_MOTOR]);
-        }
+    switch (command.type) {
+    case MOTION_CMD_FORWARD:
+    case MOTION_CMD_BACKWARD:
+        startDrive(driver, command.targetEdges);
+        break;
+    case MOTION_CMD_TURN_LEFT:
+    case MOTION_CMD_TURN_RIGHT:
+        startTurn(driver, command.targetEdges);
+        break;
+    case MOTION_CMD_SWING_TURN_LEFT:
+        startSwingTurn(driver, command.targetEdges, LEFT);
+        break;
+    case MOTION_CMD_SWING_TURN_RIGHT:
+        startSwingTurn(driver, command.targetEdges, RIGHT);
+        break;
+    case MOTION_CMD_STOP:
+        MOTOR_POSITION_clear_speed_counters(driver->motorPosition);
+        driver->stoppedSamples = 0;
+        startMotion(driver, MOTION_WAIT_STOP);
+        break;
+    }
+}
 
-        if (dir == RIGHT) {
-            PWM_DRIVER_enable(driver->pwmRightMotor);
-            PWM_DRIVER_disable(driver->pwmLeftMotor);
-        } else {
-            PWM_DRIVER_disable(driver->pwmRightMotor);
-            PWM_DRIVER_enable(driver->pwmLeftMotor);
+/**
+ * H-bridge direction a command drives the motors in, IDLE for none
+ */
+static MoveDirection commandDirection(MotionCommandType type) {
+    switch (type) {
+    case MOTION_CMD_FORWARD:
+        return FORWARD;
+    case MOTION_CMD_BACKWARD:
+        return BACKWARD;
+    case MOTION_CMD_TURN_LEFT:
+    case MOTION_CMD_SWING_TURN_LEFT:
+        return TURN_LEFT;
+    case MOTION_CMD_TURN_RIGHT:
+    case MOTION_CMD_SWING_TURN_RIGHT:
+        return TURN_RIGHT;
+    default:
+        return IDLE;
+    }
+}
+
+/**
+ * Set the H-bridge for direction and start a new segment. No delay: the
+ * motors must have been disabled long enough when the direction changes
+ */
+static void setDirection(DrivingDriver* driver, MoveDirection direction) {
+    int turn = direction == TURN_LEFT || direction == TURN_RIGHT;
+
+    driver->previousDirection = driver->direction;
+    if (direction != driver->direction || turn) {
+        switch (direction) {
+        case FORWARD:
+            HBRIDGE_DRIVER_left_motor_forward(driver->hbridge);
+            HBRIDGE_DRIVER_right_motor_forward(driver->hbridge);
+            break;
+        case BACKWARD:
+            HBRIDGE_DRIVER_left_motor_backward(driver->hbridge);
+            HBRIDGE_DRIVER_right_motor_backward(driver->hbridge);
+            break;
+        case TURN_LEFT:
+            HBRIDGE_DRIVER_left_motor_backward(driver->hbridge);
+            HBRIDGE_DRIVER_right_motor_forward(driver->hbridge);
+            break;
+        case TURN_RIGHT:
+            HBRIDGE_DRIVER_left_motor_forward(driver->hbridge);
+            HBRIDGE_DRIVER_right_motor_backward(driver->hbridge);
+            break;
+        default:
+            break;
         }
+        resetErrors(driver);
+        driver->direction = direction;
+    }
+    startSegment(driver);
+    if (turn) {
+        MOTOR_POSITION_clear_speed_counters(driver->motorPosition);
+    }
+}
+
+/**
+ * Report the end of the active command
+ */
+static void endCommand(DrivingDriver* driver, MotionStatus status) {
+    u32 id = driver->activeCommandId;
+    driver->activeCommandId = 0;
+    driver->completedCommandId = id;
+    if (driver->motionCallback) {
+        driver->motionCallback(driver->motionCallbackRef, id, status);
+    }
+}
+
+/**
+ * Queue a command, waiting for room in the queue
+ */
+static u32 queueCommand(DrivingDriver* driver, MotionCommandType type,
+        double value) {
+    u32 id;
+    while ((id = DRIVING_DRIVER_queue_command(driver, type, value)) == 0) {
+    }
+    return id;
+}
+
+/**
+ * Queue a command and wait until it ends
+ */
+static void runCommand(DrivingDriver* driver, MotionCommandType type,
+        double value) {
+    u32 id = queueCommand(driver, type, value);
+    while (!DRIVING_DRIVER_command_done(driver, id)) {
+    }
+}
+
+/**
+ * Keep the control tick out while the queue is updated, returns the MSR to
+ * give to unlockControlTick
+ */
+static u32 lockControlTick(void) {
+    u32 msr = mfmsr();
+    microblaze_disable_interrupts();
+    return msr;
+}
+
+/**
+ * Enable interrupts again if they were enabled by lockControlTick
+ */
+static void unlockControlTick(u32 msr) {
+    if (msr & MSR_IE_MASK) {
+        microblaze_enable_interrupts();
+    }
+}
+
+/**
+ * Returns 1 on the ticks where the speed and light controllers run
+ */
+static int speedLoopDue(DrivingDriver* driver) {
+    if (++driver->speedLoopCount < driver->speedLoopDivider) {
+        return 0;
+    }
+    driver->speedLoopCount = 0;
+    return 1;
+}
+
+/**
+ * Start the velocity profile of a straight move and add the speed loop to
+ * the distance controller outputs in driver->dutyTicks
+ */
+static void startDistanceDutyCycles(DrivingDriver* driver) {
+    int motor_speed[2];
+    driver->speedTargetRpm = MOTION_PROFILE_start(&driver->profile,
+            driver->driveRpm);
+    MOTOR_POSITION_get_speeds(driver->motorPosition, motor_speed);
+    SPEED_PID_CONTROLLER_get_new_outputs(driver->speedPIDController,
+            driver->speedTargetRpm, motor_speed, driver->speedDutyTicks);
+    addSpeedDutyCycles(driver);
+}
+
+/**
+ * Straight moves: the speed loop sets the duty cycle of each wheel, the
+ * distance controller adds its correction over its base to keep the wheels
+ * together
+ */
+static void addSpeedDutyCycles(DrivingDriver* driver) {
+    s32 base = driver->distancePIDController->baseDutyTicks;
+    for (int i = 0; i < 2; i++) {
+        s32 duty = (s32) driver->dutyTicks[i] - base
+                + (s32) driver->speedDutyTicks[i];
+        driver->dutyTicks[i] = duty > 0 ? duty : 0;
+    }
+}
+
+/**
+ * Start measuring positions from here, the odometry keeps counting
+ */
+static void startSegment(DrivingDriver* driver) {
+    MOTOR_POSITION_get_odometry(driver->motorPosition,
+            driver->segmentStartEdges);
+}
+
+/**
+ * Feed the pose estimator with the edges turned since the last tick, signed
+ * by the direction each wheel is driven
+ */
+static void updatePose(DrivingDriver* driver) {
+    u64 edges[2];
+    s32 right;
+    s32 left;
 
-        MOTOR_POSITION_get_positions(driver->motorPosition, motor_position);
+    if (!driver->poseEstimator) {
+        return;
+    }
+    MOTOR_POSITION_get_odometry(driver->motorPosition, edges);
+    right = edges[RIGHT_MOTOR] - driver->poseEdges[RIGHT_MOTOR];
+    left = edges[LEFT_MOTOR] - driver->poseEdges[LEFT_MOTOR];
+    driver->poseEdges[RIGHT_MOTOR] = edges[RIGHT_MOTOR];
+    driver->poseEdges[LEFT_MOTOR] = edges[LEFT_MOTOR];
+
+    switch (driver->direction) {
+    case BACKWARD:
+        right = -right;
+        left = -left;
+        break;
+    case TURN_LEFT:
+        left = -left;
+        break;
+    case TURN_RIGHT:
+        right = -right;
+        break;
+    default:
+        break;
     }
+    POSE_ESTIMATOR_update(driver->poseEstimator, right, left);
+}
+
+/**
+ * Edges turned by each motor since startSegment
+ */
+static void getSegmentPositions(DrivingDriver* driver, s32 positions[]) {
+    u64 edges[2];
+    MOTOR_POSITION_get_odometry(driver->motorPosition, edges);
+    positions[RIGHT_MOTOR] = edges[RIGHT_MOTOR]
+            - driver->segmentStartEdges[RIGHT_MOTOR];
+    positions[LEFT_MOTOR] = edges[LEFT_MOTOR]
+            - driver->segmentStartEdges[LEFT_MOTOR];
+}
+
+/**
+ * Right motor position minus left motor position since startSegment
+ */
+static s32 getSegmentPositionDifference(DrivingDriver* driver) {
+    s32 positions[2];
+    getSegmentPositions(driver, positions);
+    return positions[RIGHT_MOTOR] - positions[LEFT_MOTOR];
+}
+
+/**
+ * Mean distance in edges traveled by both motors since startSegment
+ */
+static s32 getSegmentDistance(DrivingDriver* driver) {
+    s32 positions[2];
+    getSegmentPositions(driver, positions);
+    return (positions[RIGHT_MOTOR] + positions[LEFT_MOTOR]) / 2;
+}
+
+/**
+ * Hand a prepared motion over to the control tick
+ */
+static void startMotion(DrivingDriver* driver, MotionMode mode) {
+    driver->speedLoopCount = 0;
+    driver->motionMode = mode;
+}
+
+/**
+ * Called from the control tick when the motion reaches its target
+ */
+static void finishMotion(DrivingDriver* driver) {
     disableMotors(driver);
+    driver->motionMode = MOTION_IDLE;
+}
+
+/**
+ * Load driver->dutyTicks into both PWMs and enable both motors. Running
+ * motors keep their drive, the new duty cycles take effect at the next PWM
+ * period
+ */
+static void applyDutyCycles(DrivingDriver* driver) {
+    PWM_DRIVER_set_duty_ticks_pair(driver->pwmRightMotor,
+            driver->dutyTicks[RIGHT_MOTOR], driver->pwmLeftMotor,
+            driver->dutyTicks[LEFT_MOTOR]);
+    enableMotors(driver);
+}
+
+/**
+ * Load driver->dutyTicks into the PWM of the swing turn wheel and keep the
+ * other motor stopped
+ */
+static void applySwingDutyCycle(DrivingDriver* driver) {
+    if (driver->swingDirection == RIGHT) {
+        PWM_DRIVER_set_duty_ticks_pair(driver->pwmRightMotor,
+                driver->dutyTicks[RIGHT_MOTOR], driver->pwmLeftMotor, 0);
+    } else {
+        PWM_DRIVER_set_duty_ticks_pair(driver->pwmRightMotor, 0,
+                driver->pwmLeftMotor, driver->dutyTicks[LEFT_MOTOR]);
+    }
+    enableMotors(driver);
+}
+
+/**
+ * Distance to the obstacle in front. Takes the latest sample when the
+ * PmodToF is ranging continuously, measures otherwise. A stale sample or a
+ * failed measurement reads as 0 so that the bot stops
+ */
+static int obstacleDistanceMm(void) {
+    TOFSAMPLE sample;
+    double distance;
+
+    if (PmodToF_get_latest_sample(&sample)) {
+        if (PmodToF_get_ranging_time_ms() - sample.timeMs
+                > TOF_MAX_SAMPLE_AGE_MS) {
+            return 0;
+        }
+        return sample.distanceMm;
+    }
+    distance = PmodToF_perform_distance_measurement();
+    if (distance < 0) {
+        return 0;
+    }
+    return 1000 * distance;
 }
 
 /**
@@ -650,21 +1381,7 @@ void DRIVING_DRIVER_swing_turn(DrivingDriver* driver, double arclength,
  * @param driver        Driving driver to use with its actual state
  */
 void DRIVING_DRIVER_delay_until_stop(DrivingDriver* driver) {
-
-    MOTOR_POSITION_clear_speed_counters(driver->motorPosition);
-
-    int motor_speed[2];
-    MOTOR_POSITION_get_speeds(driver->motorPosition, motor_speed);
-    while (motor_speed[RIGHT_MOTOR] + motor_speed[LEFT_MOTOR]) {
-        for (int i = 0; i < 3; i++) {
-            while (motor_speed[RIGHT_MOTOR] + motor_speed[LEFT_MOTOR]) {
-                usleep(SAMPLE_PER);
-                MOTOR_POSITION_get_speeds(driver->motorPosition, motor_speed);
-            }
-            usleep(SAMPLE_PER);
-        }
-        MOTOR_POSITION_get_speeds(driver->motorPosition, motor_speed);
-    }
+    runCommand(driver, MOTION_CMD_STOP, 0);
 }
 
 /**
@@ -712,6 +1429,7 @@ void resetErrors(DrivingDriver* driver) {
  */
 void DRIVING_DRIVER_drive_forward_continuous_light(DrivingDriver* driver,
         double distanceCm, u16 lightTarget) {
+    DRIVING_DRIVER_wait_idle(driver);
     DRIVING_DRIVER_set_direction_forward(driver);
     DRIVING_DRIVER_drive_light(driver, distanceCm, lightTarget);
 }
@@ -730,7 +1448,8 @@ u16 DRIVING_DRIVER_light(COLOR_Data sample) {
  * void DRIVING_DRIVER_drive_cm(DrivingDriver* driver, double distance_cm)
  *
  * @details Drive motors given distance using light control (motors will have
- *       turned about the same amount at the end)
+ *       turned about the same amount at the end). The light sensor is read
+ *       here while the control tick steers on the last sample.
  *
  * @param driver            Driving driver to use with its actual state
  * @param distance_cm       Distance in cm to drive the Bot
@@ -739,58 +1458,32 @@ u16 DRIVING_DRIVER_light(COLOR_Data sample) {
 void DRIVING_DRIVER_drive_light(DrivingDriver* driver, double distance_cm,
         u16 lightTarget) {
 
-    int16_t dist_converted = (int16_t) (distance_cm
+    driver->targetEdges = (s32) (distance_cm
             * driver->distanceCmCorrection); // TODO cm to sensed edges
 
-    int16_t light_diff = DRIVING_DRIVER_light(
+    driver->lightDifference = DRIVING_DRIVER_light(
             COLOR_GetData(driver->colorSensor)) - lightTarget;
-    double duty_cycle[2];
-
-    LIGHT_PID_CONTROLLER_get_new_outputs(driver->lightPIDController, light_diff,
-            duty_cycle);
-
-    int16_t dist_traveled = MOTOR_POSITION_get_distance_traveled(
-            driver->motorPosition);
-
-    disableMotors(driver);
-
-    PWM_DRIVER_set_duty_pct(driver->pwmRightMotor, duty_cycle[RIGHT_MOTOR]);
-    PWM_DRIVER_set_duty_pct(driver->pwmLeftMotor, duty_cycle[LEFT_MOTOR]);
 
-    enableMotors(driver);
-
-    while (dist_traveled < dist_converted) {
-        usleep(SAMPLE_PER);
-
-        light_diff = DRIVING_DRIVER_light(COLOR_GetData(driver->colorSensor))
-                - lightTarget;
+    LIGHT_PID_CONTROLLER_get_new_outputs(driver->lightPIDController,
+            driver->lightDifference, driver->dutyTicks);
 
-        LIGHT_PID_CONTROLLER_get_new_outputs(driver->lightPIDController,
-                light_diff, duty_cycle);
-
-        disableMotors(driver);
-
-        PWM_DRIVER_set_duty_pct(driver->pwmRightMotor, duty_cycle[RIGHT_MOTOR]);
-        PWM_DRIVER_set_duty_pct(driver->pwmLeftMotor, duty_cycle[LEFT_MOTOR]);
-
-        enableMotors(driver);
-
-        dist_traveled = MOTOR_POSITION_get_distance_traveled(
-                driver->motorPosition);
+    applyDutyCycles(driver);
 
+    startMotion(driver, MOTION_LIGHT);
+    while (driver->motionMode != MOTION_IDLE) {
+        driver->lightDifference = DRIVING_DRIVER_light(
+                COLOR_GetData(driver->colorSensor)) - lightTarget;
     }
 
-    driver->previousLightDifference = light_diff;
-
-    disableMotors(driver);
-
+    driver->previousLightDifference = driver->lightDifference;
 }
 
 /**
  * void DRIVING_DRIVER_drive_continuos_to_obstacle(DrivingDriver* driver, double distance_cm, double obstacle_distance_cm)
  *
  * @details Drive motors given distance using positional control (motors will have
- *       turned about the same amount at the end). Stops if obstacle detected
+ *       turned about the same amount at the end). Stops if obstacle detected.
+ *       The distance sensor is read here while the control tick drives.
  *
  * @param driver                Driving driver to use with its actual state
  * @param distance_cm           Distance in cm to drive the Bot
@@ -800,79 +1493,41 @@ void DRIVING_DRIVER_drive_light(DrivingDriver* driver, double distance_cm,
  */
 int DRIVING_DRIVER_drive_to_obstacle(DrivingDriver* driver, double distance_cm,
         double obstacle_distance_cm) {
-    int N = 1;
-    int sum = 0;
-    int distance_val = 0;
-    int distance_val_avg = 0;
+    int obstacle_distance_mm = obstacle_distance_cm * 10;
+    int distance_mm;
 
+    DRIVING_DRIVER_wait_idle(driver);
     DRIVING_DRIVER_set_direction_forward(driver);
 
-    int16_t dist_converted = (int16_t) (distance_cm
+    driver->targetEdges = (s32) (distance_cm
             * driver->distanceCmCorrection); // TODO cm to sensed edges
 
-    int16_t pos_diff = MOTOR_POSITION_get_position_difference(
-            driver->motorPosition);
-    double duty_cycle[2];
+    s32 pos_diff = getSegmentPositionDifference(driver);
     if (driver->direction == driver->previousDirection) {
         DISTANCE_PID_CONTROLLER_get_new_outputs(driver->distancePIDController,
-                driver->previousPositionDifference, duty_cycle);
+                driver->previousPositionDifference, driver->dutyTicks);
     } else {
         DISTANCE_PID_CONTROLLER_get_new_outputs(driver->distancePIDController,
-                pos_diff, duty_cycle);
+                pos_diff, driver->dutyTicks);
     }
-
-    int16_t dist_traveled = MOTOR_POSITION_get_distance_traveled(
-            driver->motorPosition);
+    startDistanceDutyCycles(driver);
 
     disableMotors(driver);
 
-    sum = 0;
-    // N distance values that are measured will be averaged into a final distance value
-    for (int j = 0; j < N; j++) {
-        distance_val = 100 * PmodToF_perform_distance_measurement(); // the distance value is in centimeters
-        sum = sum + distance_val;
+    distance_mm = obstacleDistanceMm();
+    if (distance_mm > obstacle_distance_mm) {
+        applyDutyCycles(driver);
+        startMotion(driver, MOTION_DISTANCE);
     }
-    distance_val_avg = sum / N;
-
-    PWM_DRIVER_set_duty_pct(driver->pwmRightMotor, duty_cycle[RIGHT_MOTOR]);
-    PWM_DRIVER_set_duty_pct(driver->pwmLeftMotor, duty_cycle[LEFT_MOTOR]);
-
-    enableMotors(driver);
-
-    while ((dist_traveled < dist_converted)
-            && (distance_val_avg > obstacle_distance_cm)) {
-        usleep(SAMPLE_PER);
-        pos_diff = MOTOR_POSITION_get_position_difference(
-                driver->motorPosition);
 
-        DISTANCE_PID_CONTROLLER_get_new_outputs(driver->distancePIDController,
-                pos_diff, duty_cycle);
-
-        disableMotors(driver);
-
-        PWM_DRIVER_set_duty_pct(driver->pwmRightMotor, duty_cycle[RIGHT_MOTOR]);
-        PWM_DRIVER_set_duty_pct(driver->pwmLeftMotor, duty_cycle[LEFT_MOTOR]);
-
-        enableMotors(driver);
-
-        sum = 0;
-        // N distance values that are measured will be averaged into a final distance value
-        for (int j = 0; j < N; j++) {
-            distance_val = 100 * PmodToF_perform_distance_measurement(); // the distance value is in centimeters
-            sum = sum + distance_val;
+    while (driver->motionMode != MOTION_IDLE) {
+        distance_mm = obstacleDistanceMm();
+        if (distance_mm <= obstacle_distance_mm) {
+            DRIVING_DRIVER_stop_motion(driver);
         }
-        distance_val_avg = sum / N;
-
-        dist_traveled = MOTOR_POSITION_get_distance_traveled(
-                driver->motorPosition);
-
     }
 
-    driver->previousPositionDifference = pos_diff;
-
-    disableMotors(driver);
-
-    if (distance_val_avg <= obstacle_distance_cm) {
+    if (distance_mm <= obstacle_distance_mm) {
         DRIVING_DRIVER_delay_until_stop(driver);
         return 1; // obstacle detected
     } else {
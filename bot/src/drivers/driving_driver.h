@@ -29,7 +29,13 @@
 /*                                                                      */
 /*  Call BOT_DRIVER_init for initializing the driver                    */
 /*                                                                      */
+/*  Call DRIVING_DRIVER_control_tick at DRIVING_DRIVER_set_control_rate */
+/*  from a timer interrupt, it runs the PID controllers of the motion   */
+/*  in progress and starts the queued motion commands                   */
 /*                                                                      */
+/*  DRIVING_DRIVER_queue_command returns at once, poll                  */
+/*  DRIVING_DRIVER_command_done or set a callback with                  */
+/*  DRIVING_DRIVER_set_motion_callback to know when the command ends    */
 /*                                                                      */
 /************************************************************************/
 /*  Revision History:                                                   */
@@ -48,6 +54,8 @@
 #include "speed_pid_control.h"
 #include "hbridge_driver.h"
 #include "light_pid_control.h"
+#include "pose_estimator.h"
+#include "motion_profile.h"
 #include "PmodCOLOR.h"
 
 #include "../PmodToF/PmodToF.h"
@@ -60,6 +68,41 @@ typedef enum TurnDirection {
     LEFT = 0, RIGHT =1
 } TurnDirection;
 
+// Motion run by the control tick
+typedef enum MotionMode {
+    MOTION_IDLE, MOTION_DISTANCE, MOTION_TURN, MOTION_SWING_TURN, MOTION_LIGHT,
+    MOTION_WAIT_STOP
+} MotionMode;
+
+// Commands for the motion queue
+typedef enum MotionCommandType {
+    MOTION_CMD_FORWARD,         // value in cm
+    MOTION_CMD_BACKWARD,        // value in cm
+    MOTION_CMD_TURN_LEFT,       // value in degrees
+    MOTION_CMD_TURN_RIGHT,      // value in degrees
+    MOTION_CMD_SWING_TURN_LEFT, // value in degrees
+    MOTION_CMD_SWING_TURN_RIGHT,// value in degrees
+    MOTION_CMD_STOP             // wait until both motors have stopped
+} MotionCommandType;
+
+typedef struct MotionCommand {
+    MotionCommandType type;
+    s32               targetEdges;  // converted when queued, the tick is integer only
+    u32               id;
+} MotionCommand;
+
+typedef enum MotionStatus {
+    MOTION_DONE, MOTION_CANCELED
+} MotionStatus;
+
+// Called from the control tick when a queued command ends. Queue follow-up
+// commands from it with DRIVING_DRIVER_queue_command_edges, integer only
+typedef void (*MotionCallback)(void* callbackRef, u32 commandId,
+        MotionStatus status);
+
+// Number of commands the motion queue holds, power of 2
+#define DRIVING_DRIVER_QUEUE_SIZE 16
+
 typedef enum SensorsConfiguration {
     FRONT_SENSORS, REAR_SENSORS
 } SensorsConfiguration;
@@ -71,7 +114,7 @@ typedef struct DrivingDriver {
     u32                    pwmPeriod_ns;
     MoveDirection          direction;
     MoveDirection          previousDirection;
-    int16_t                previousPositionDifference;
+    s32                    previousPositionDifference;
     SpeedPIDController*    speedPIDController;
     DistancePIDController* distancePIDController;
     HBridgeDriver*         hbridge;
@@ -81,6 +124,31 @@ typedef struct DrivingDriver {
     LightPIDController*    lightPIDController;
     int16_t                previousLightDifference;
     PmodCOLOR*             colorSensor;
+    volatile MotionMode    motionMode;
+    s32                    targetEdges;
+    u64                    segmentStartEdges[2];
+    int                    speedTargetRpm;
+    TurnDirection          swingDirection;
+    volatile int16_t       lightDifference;
+    u32                    controlRateHz;
+    u32                    speedLoopDivider;
+    u32                    speedLoopCount;
+    u32                    dutyTicks[2];
+    int                    stoppedSamples;
+    int                    directionSettling;
+    MotionCommand          queue[DRIVING_DRIVER_QUEUE_SIZE];
+    volatile u32           queueHead;
+    volatile u32           queueTail;
+    u32                    lastCommandId;
+    volatile u32           activeCommandId;
+    volatile u32           completedCommandId;
+    MotionCallback         motionCallback;
+    void*                  motionCallbackRef;
+    PoseEstimator*         poseEstimator;
+    u64                    poseEdges[2];
+    MotionProfile          profile;
+    u32                    driveRpm;
+    u32                    speedDutyTicks[2];
 } DrivingDriver;
 
 /************ Function Prototypes ************/
@@ -96,6 +164,44 @@ void DRIVING_DRIVER_init(DrivingDriver* driver, MotorPosition* motorPosition,
 
 void DRIVING_DRIVER_end(DrivingDriver* driver);
 
+void DRIVING_DRIVER_set_control_rate(DrivingDriver* driver, u32 controlRateHz,
+        u32 speedLoopRateHz);
+
+void DRIVING_DRIVER_set_motion_profile(DrivingDriver* driver, u32 driveRpm,
+        u32 accelerationRpmPerS, u32 minRpm);
+
+void DRIVING_DRIVER_control_tick(void* callbackRef);
+
+void DRIVING_DRIVER_stop_motion(DrivingDriver* driver);
+
+u32 DRIVING_DRIVER_queue_command(DrivingDriver* driver, MotionCommandType type,
+        double value);
+
+u32 DRIVING_DRIVER_queue_command_edges(DrivingDriver* driver,
+        MotionCommandType type, s32 targetEdges);
+
+s32 DRIVING_DRIVER_command_target_edges(DrivingDriver* driver,
+        MotionCommandType type, double value);
+
+int DRIVING_DRIVER_command_done(DrivingDriver* driver, u32 commandId);
+
+int DRIVING_DRIVER_is_idle(DrivingDriver* driver);
+
+void DRIVING_DRIVER_wait_idle(DrivingDriver* driver);
+
+void DRIVING_DRIVER_cancel_commands(DrivingDriver* driver);
+
+void DRIVING_DRIVER_set_motion_callback(DrivingDriver* driver,
+        MotionCallback callback, void* callbackRef);
+
+void DRIVING_DRIVER_set_pose_estimator(DrivingDriver* driver,
+        PoseEstimator* poseEstimator);
+
+void DRIVING_DRIVER_get_pose(DrivingDriver* driver, Pose* pose);
+
+void DRIVING_DRIVER_set_pose(DrivingDriver* driver, s32 xMm, s32 yMm,
+        s32 headingMdeg);
+
 void DRIVING_DRIVER_drive_forward_cm(DrivingDriver* driver, double distanceCm);
 
 void DRIVING_DRIVER_drive_backward_cm(DrivingDriver* driver, double distanceCm);
@@ -41,27 +41,30 @@
 /**
  * void LIGHT_PID_CONTROLLER_init(LightPIDController * controller,
  *         double KProportional, double KIntegral, double KDerivative,
- *         double baseDutyCyclePct)
+ *         double baseDutyCyclePct, u32 periodTicks)
  *
- * Uses a PID controller to compute new duty cycles for motor1 and motor2
- * with goal of minimizing light difference from target. Assumes that this
- * function gets called at regular time intervals.
+ * Configure a PID controller to compute new duty cycles for motor1 and motor2
+ * with goal of minimizing light difference from target.
+ * The gains are given in duty cycle per error unit and stored as Q16.16 PWM
+ * timer ticks, so only the init does floating point.
  *
- * @param controller            Distance PID controller configuration and state
+ * @param controller            Light PID controller configuration and state
  * @param KProportional         PID proportional term
  * @param KIntegral             PID Integral term
  * @param KDerivative           PID Derivative term
  * @param baseDutyCyclePct      Base duty cycle percentage
+ * @param periodTicks           PWM period in timer ticks
  */
 void LIGHT_PID_CONTROLLER_init(LightPIDController * controller,
         double KProportional, double KIntegral, double KDerivative,
-        double baseDutyCyclePct) {
-
-    controller->KProportional = KProportional;
-    controller->KIntegral = KIntegral;
-    controller->KDerivative = KDerivative;
-    controller->baseDutyCyclePct = baseDutyCyclePct;
-
+        double baseDutyCyclePct, u32 periodTicks) {
+
+    controller->periodTicks = periodTicks;
+    PID_CONTROLLER_init(&controller->pid,
+            PID_Q16(KProportional * periodTicks),
+            PID_Q16(KIntegral * periodTicks),
+            PID_Q16(KDerivative * periodTicks), 0, 0);
+    LIGHT_PID_CONTROLLER_set_duty_cycle(controller, baseDutyCyclePct);
 }
 
 /**
@@ -70,61 +73,43 @@ void LIGHT_PID_CONTROLLER_init(LightPIDController * controller,
  *
  * Set the new base duty cycle
  *
- * @param controller        Distance PID controller configuration and state
+ * @param controller        Light PID controller configuration and state
  * @param baseDutyCyclePct  Base duty cycle percentage 0.4 typical 0.75 for fast speed
- *                          If using PMODColor do not exceed .2 for fast
  */
 void LIGHT_PID_CONTROLLER_set_duty_cycle(LightPIDController * controller,
         double baseDutyCyclePct) {
-    controller->baseDutyCyclePct = baseDutyCyclePct;
+    s32 base = baseDutyCyclePct * controller->periodTicks;
+    s32 period = controller->periodTicks;
+    controller->baseDutyTicks = base;
+    // the correction speeds up one motor, up to the period
+    PID_CONTROLLER_set_limits(&controller->pid, base - period, period - base);
 }
 
 /**
  * void LIGHT_PID_CONTROLLER_get_new_outputs(
- *      LightPIDController * controller, int light_diff, double dutyCyclePct[])
+ *      LightPIDController * controller, int light_diff, u32 dutyTicks[])
  *
  *  Uses a PID controller to compute new duty cycles for the right motor and the left motor
- *  with goal of minimizing light difference to 0 and store them in duty_cycle.
+ *  with goal of minimizing light difference to 0 and store them in dutyTicks.
  *  Assumes that this function gets called at regular time intervals
  *
- * @param controller        Distance PID controller configuration and state
+ * @param controller        Light PID controller configuration and state
  * @param light_diff
- * @param dutyCyclePct      returns base duty cycle values (from 0.0 to 1.0)
- *                          for right and left motors
+ * @param dutyTicks         returns duty cycles in PWM timer ticks (from 0 to
+ *                          the period) for right and left motors
  */
 void LIGHT_PID_CONTROLLER_get_new_outputs(
-        LightPIDController * controller, int light_diff, double dutyCyclePct[]) {
-
-    controller->accumulated_error += light_diff;
-
-
-    double correction = controller->KProportional * light_diff
-            + controller->KIntegral * controller->accumulated_error
-            + controller->KDerivative * (light_diff - controller->previous_error);
+        LightPIDController * controller, int light_diff, u32 dutyTicks[]) {
 
+    s32 correction = PID_CONTROLLER_update(&controller->pid, light_diff);
 
-    if (correction > 0.0) {
-        dutyCyclePct[0] = controller->baseDutyCyclePct + correction; //
-        dutyCyclePct[1] = controller->baseDutyCyclePct ;
-    } else  {
-        dutyCyclePct[0] = controller->baseDutyCyclePct;
-        dutyCyclePct[1] = controller->baseDutyCyclePct - correction;
+    dutyTicks[0] = controller->baseDutyTicks;
+    dutyTicks[1] = controller->baseDutyTicks;
+    if (correction > 0) {
+        dutyTicks[0] += correction;
+    } else {
+        dutyTicks[1] -= correction;
     }
-    controller->previous_error = light_diff;
-
-    // Bound duty cycles between 0 and 1
-    if (dutyCyclePct[0] < 0.0) {
-        dutyCyclePct[0] = 0.0;
-    } else if (dutyCyclePct[0] > 1.0) {
-        dutyCyclePct[0] = 1.0;
-    }
-
-    if (dutyCyclePct[1] < 0.0) {
-        dutyCyclePct[1] = 0.0;
-    } else if (dutyCyclePct[1] > 1.0) {
-        dutyCyclePct[1] = 1.0;
-    }
-
 }
 
 /**
@@ -132,9 +117,8 @@ void LIGHT_PID_CONTROLLER_get_new_outputs(
  *
  * Reset accumulated errors and previous errors to 0
  *
- * @param controller    Distance PID controller configuration and state
+ * @param controller    Light PID controller configuration and state
  */
 void LIGHT_PID_CONTROLLER_reset_errors(LightPIDController * controller) {
-    controller->accumulated_error = 0;
-    controller->previous_error = 0;
+    PID_CONTROLLER_reset_errors(&controller->pid);
 }
@@ -52,23 +52,22 @@
 #ifndef LIGHT_PID_CONTROLLER_H
 #define LIGHT_PID_CONTROLLER_H
 
+#include "pid_controller.h"
+
 typedef struct LightPIDController {
-    double KProportional;
-    double KIntegral;
-    double KDerivative;
-    int accumulated_error;
-    int previous_error;
-    double baseDutyCyclePct;
+    PIDController pid;
+    u32 baseDutyTicks;
+    u32 periodTicks;
 } LightPIDController;
 
 /************ Function Prototypes ************/
 
 void LIGHT_PID_CONTROLLER_init(LightPIDController * controller,
         double KProportional, double KIntegral, double KDerivative,
-        double baseDutyCyclePct);
+        double baseDutyCyclePct, u32 periodTicks);
 
 void LIGHT_PID_CONTROLLER_get_new_outputs(
-        LightPIDController * controller, int pos_diff, double duty_cycle[]);
+        LightPIDController * controller, int pos_diff, u32 dutyTicks[]);
 
 void LIGHT_PID_CONTROLLER_reset_errors(LightPIDController * controller);
 
@@ -0,0 +1,96 @@
+/************************************************************************/
+/*                                                                      */
+/*  motion_profile.c: Velocity profile generator for the ArtyBot.       */
+/*  This file is part of the Arty S7 Bot.                               */
+/*                                                                      */
+/************************************************************************/
+
+/*
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+ */
+
+/************************************************************************/
+/*  Module Description:                                                 */
+/*                                                                      */
+/* Trapezoidal velocity profile planned online from the remaining       */
+/* distance, so it follows the real wheel position.                     */
+/*                                                                      */
+/************************************************************************/
+
+#include "motion_profile.h"
+
+/**
+ * void MOTION_PROFILE_init(MotionProfile* profile, u32 edgesPerWheelRev,
+ *      u32 tickRateHz, u32 accelerationRpmPerS, u32 minRpm)
+ *
+ * @details configure the profile
+ *
+ * @param profile               Motion profile with actual state reference
+ * @param edgesPerWheelRev      encoder edges per wheel revolution
+ * @param tickRateHz            rate MOTION_PROFILE_next is called at
+ * @param accelerationRpmPerS   acceleration and deceleration
+ * @param minRpm                lowest set point, at start and end of moves
+ */
+void MOTION_PROFILE_init(MotionProfile* profile, u32 edgesPerWheelRev,
+        u32 tickRateHz, u32 accelerationRpmPerS, u32 minRpm) {
+    profile->acceleration = ((s64) accelerationRpmPerS << 16) / tickRateHz;
+    profile->minVelocity = minRpm << 16;
+    // braking from v RPM takes v^2 * edgesPerWheelRev / (120 * a) edges
+    profile->brakeFactor = ((s64) 120 * accelerationRpmPerS << 16)
+            / edgesPerWheelRev;
+    profile->cruiseVelocity = profile->minVelocity;
+    profile->velocity = profile->minVelocity;
+}
+
+/**
+ * int MOTION_PROFILE_start(MotionProfile* profile, u32 cruiseRpm)
+ *
+ * @details start a move from the minimum speed
+ *
+ * @param profile           Motion profile with actual state
+ * @param cruiseRpm         highest set point of the move
+ * @return  first set point in RPM
+ */
+int MOTION_PROFILE_start(MotionProfile* profile, u32 cruiseRpm) {
+    profile->cruiseVelocity = cruiseRpm << 16;
+    if (profile->cruiseVelocity < profile->minVelocity) {
+        profile->cruiseVelocity = profile->minVelocity;
+    }
+    profile->velocity = profile->minVelocity;
+    return profile->velocity >> 16;
+}
+
+/**
+ * int MOTION_PROFILE_next(MotionProfile* profile, s32 remainingEdges)
+ *
+ * @details advance the profile one tick
+ *
+ * @param profile           Motion profile with actual state
+ * @param remainingEdges    edges left to the target of the move
+ * @return  set point in RPM
+ */
+int MOTION_PROFILE_next(MotionProfile* profile, s32 remainingEdges) {
+    s64 velocitySquared = ((s64) profile->velocity * profile->velocity) >> 16;
+    s64 brakingSquared = (s64) remainingEdges * profile->brakeFactor;
+
+    if (velocitySquared >= brakingSquared) {
+        profile->velocity -= profile->acceleration;
+        if (profile->velocity < profile->minVelocity) {
+            profile->velocity = profile->minVelocity;
+        }
+    } else if (profile->velocity < profile->cruiseVelocity) {
+        profile->velocity += profile->acceleration;
+        if (profile->velocity > profile->cruiseVelocity) {
+            profile->velocity = profile->cruiseVelocity;
+        }
+    }
+    return profile->velocity >> 16;
+}
@@ -0,0 +1,52 @@
+/************************************************************************/
+/*                                                                      */
+/*  motion_profile.h: Velocity profile generator Header for the Bot.    */
+/*  This file is part of the Arty S7 Bot.                               */
+/*                                                                      */
+/************************************************************************/
+
+/*
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+ */
+
+/************************************************************************/
+/*  Module Description:                                                 */
+/*                                                                      */
+/* Trapezoidal velocity profile for a move of a given number of edges.  */
+/* Every tick the wheel speed set point ramps up to the cruise speed,   */
+/* and ramps down as soon as the remaining edges are not more than the  */
+/* distance needed to brake. The set point never drops below a minimum  */
+/* speed so the move always reaches its target. Integer only.           */
+/*                                                                      */
+/*  Call MOTION_PROFILE_init once, MOTION_PROFILE_start for each move   */
+/*  and MOTION_PROFILE_next on every tick with the remaining edges      */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include "xil_types.h"
+
+typedef struct MotionProfile {
+    s32 acceleration;       // Q16.16 RPM per tick
+    s32 minVelocity;        // Q16.16 RPM
+    s32 brakeFactor;        // Q16.16 RPM^2 per edge of braking distance
+    s32 cruiseVelocity;     // Q16.16 RPM
+    s32 velocity;           // Q16.16 RPM, actual set point
+} MotionProfile;
+
+void MOTION_PROFILE_init(MotionProfile* profile, u32 edgesPerWheelRev,
+        u32 tickRateHz, u32 accelerationRpmPerS, u32 minRpm);
+int MOTION_PROFILE_start(MotionProfile* profile, u32 cruiseRpm);
+int MOTION_PROFILE_next(MotionProfile* profile, s32 remainingEdges);
+
+#endif // MOTION_PROFILE_H
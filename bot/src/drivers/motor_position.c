@@ -20,25 +20,56 @@ void MOTOR_POSITION_init(MotorPosition* motorPosition, u32 baseAddr,
     motorPosition->clkFreqHz = clkFreqHz;
     motorPosition->edgesPerRev = edgesPerRev;
     motorPosition->gearboxRatio = gearboxRatio;
+    motorPosition->rpmFactor = (u64) 60 * clkFreqHz
+            / (edgesPerRev * gearboxRatio);
+    motorPosition->odometry[RIGHT_MOTOR] = 0;
+    motorPosition->odometry[LEFT_MOTOR] = 0;
+    motorPosition->odometryUpdates = 0;
 
     MOTOR_POSITION_clear_pos_counter(motorPosition);
     MOTOR_POSITION_clear_speed_counters(motorPosition);
 }
 
 void MOTOR_POSITION_get_speeds(MotorPosition* motorPosition, int motor_speed[]) {
-    int counters_right_motor[2];
-    int counters_left_motor[2];
-    MOTOR_POSITION_get_edge_counts(motorPosition, counters_right_motor,
-            counters_left_motor);
-    double conversionFactor = 60.0 * motorPosition->clkFreqHz
-            / motorPosition->edgesPerRev / motorPosition->gearboxRatio;
-    motor_speed[RIGHT_MOTOR] = conversionFactor
-            * counters_right_motor[POS_COUNTER]
-            / counters_right_motor[CLOCK_COUNTER];
-    motor_speed[LEFT_MOTOR] = conversionFactor
-            * counters_left_motor[POS_COUNTER]
-            / counters_left_motor[CLOCK_COUNTER];
+    MotorSnapshot snapshot;
+    MOTOR_POSITION_get_snapshot(motorPosition, &snapshot);
     MOTOR_POSITION_clear_speed_counters(motorPosition);
+    MOTOR_POSITION_get_snapshot_speeds(motorPosition, &snapshot, motor_speed);
+}
+
+/**
+ * Read all the counters back to back: one read per motor gives its position
+ * and speed edges, one read gives the speed window shared by both motors.
+ */
+void MOTOR_POSITION_get_snapshot(MotorPosition* motorPosition,
+        MotorSnapshot* snapshot) {
+    u32 m1 = Xil_In32(motorPosition->baseAddr + MOTOR_POSITION_M1_POS_OFFSET);
+    u32 m2 = Xil_In32(motorPosition->baseAddr + MOTOR_POSITION_M2_POS_OFFSET);
+    snapshot->clockCycles = Xil_In32(
+            motorPosition->baseAddr + MOTOR_POSITION_CLK_OFFSET);
+    snapshot->positions[RIGHT_MOTOR] = m1 & 0xFFFF;
+    snapshot->positions[LEFT_MOTOR] = m2 & 0xFFFF;
+    snapshot->speedEdges[RIGHT_MOTOR] = m1 >> 16;
+    snapshot->speedEdges[LEFT_MOTOR] = m2 >> 16;
+}
+
+/**
+ * Motor speeds in RPM over the speed window of a snapshot, integer only.
+ * Both motors share one Q16 RPM per edge factor for the window.
+ */
+void MOTOR_POSITION_get_snapshot_speeds(MotorPosition* motorPosition,
+        MotorSnapshot* snapshot, int motor_speed[]) {
+    if (snapshot->clockCycles == 0) {
+        motor_speed[RIGHT_MOTOR] = 0;
+        motor_speed[LEFT_MOTOR] = 0;
+        return;
+    }
+    u64 rpmPerEdge = ((u64) motorPosition->rpmFactor << 16)
+            / snapshot->clockCycles;
+    motor_speed[RIGHT_MOTOR] =
+            (snapshot->speedEdges[RIGHT_MOTOR] * rpmPerEdge) >> 16;
+    motor_speed[LEFT_MOTOR] =
+            (snapshot->speedEdges[LEFT_MOTOR] * rpmPerEdge) >> 16;
 }
 
 int16_t MOTOR_POSITION_get_distance_traveled(MotorPosition* motorPosition) {
@@ -49,13 +80,12 @@ int16_t MOTOR_POSITION_get_distance_traveled(MotorPosition* motorPosition) {
 
 void MOTOR_POSITION_get_edge_counts(MotorPosition* motorPosition,
         int counters_right_motor[], int counters_left_motor[]) {
-    u32 m1Pos_addr = motorPosition->baseAddr + MOTOR_POSITION_M1_POS_OFFSET;
-    u32 m2Pos_addr = motorPosition->baseAddr + MOTOR_POSITION_M2_POS_OFFSET;
-    u32 clk_addr = motorPosition->baseAddr + MOTOR_POSITION_CLK_OFFSET;
-    counters_right_motor[POS_COUNTER] = (int) (Xil_In32(m1Pos_addr) >> 16);
-    counters_right_motor[CLOCK_COUNTER] = (int) Xil_In32(clk_addr);
-    counters_left_motor[POS_COUNTER] = (int) (Xil_In32(m2Pos_addr) >> 16);
-    counters_left_motor[CLOCK_COUNTER] = (int) Xil_In32(clk_addr);
+    MotorSnapshot snapshot;
+    MOTOR_POSITION_get_snapshot(motorPosition, &snapshot);
+    counters_right_motor[POS_COUNTER] = snapshot.speedEdges[RIGHT_MOTOR];
+    counters_right_motor[CLOCK_COUNTER] = snapshot.clockCycles;
+    counters_left_motor[POS_COUNTER] = snapshot.speedEdges[LEFT_MOTOR];
+    counters_left_motor[CLOCK_COUNTER] = snapshot.clockCycles;
 }
 
 void MOTOR_POSITION_clear_speed_counters(MotorPosition* motorPosition) {
@@ -79,4 +109,38 @@ int16_t MOTOR_POSITION_get_position_difference(MotorPosition* motorPosition) {
 void MOTOR_POSITION_clear_pos_counter(MotorPosition* motorPosition) {
     Xil_Out8(motorPosition->baseAddr + MOTOR_POSITION_CLEAR_OFFSET, 0x2);
     Xil_Out8(motorPosition->baseAddr + MOTOR_POSITION_CLEAR_OFFSET, 0x0);
+    // the odometry goes on from the cleared counters
+    motorPosition->lastPositions[RIGHT_MOTOR] = 0;
+    motorPosition->lastPositions[LEFT_MOTOR] = 0;
+}
+
+/**
+ * Add the edges counted since the last update to the odometry. The 16 bit
+ * position counters wrap around, call it often enough that no motor turns
+ * more than 65535 edges between updates, the control tick does.
+ * Not reentrant, call it from a single context.
+ */
+void MOTOR_POSITION_update_odometry(MotorPosition* motorPosition) {
+    int16_t motor_pos[2];
+    MOTOR_POSITION_get_positions(motorPosition, motor_pos);
+    for (int i = 0; i < 2; i++) {
+        u16 delta = (u16) motor_pos[i] - motorPosition->lastPositions[i];
+        motorPosition->lastPositions[i] = (u16) motor_pos[i];
+        motorPosition->odometry[i] += delta;
+    }
+    motorPosition->odometryUpdates++;
+}
+
+/**
+ * Copy the edges counted by each motor since init. Safe to call while
+ * MOTOR_POSITION_update_odometry runs from an interrupt, the copy is taken
+ * again if an update happened in between.
+ */
+void MOTOR_POSITION_get_odometry(MotorPosition* motorPosition, u64 edges[]) {
+    u32 updates;
+    do {
+        updates = motorPosition->odometryUpdates;
+        edges[RIGHT_MOTOR] = motorPosition->odometry[RIGHT_MOTOR];
+        edges[LEFT_MOTOR] = motorPosition->odometry[LEFT_MOTOR];
+    } while (updates != motorPosition->odometryUpdates);
 }
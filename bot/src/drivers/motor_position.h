@@ -43,8 +43,19 @@ typedef struct MotorPosition {
    u32 clkFreqHz;
    u32 edgesPerRev;
    u32 gearboxRatio;
+   u32 rpmFactor;                 // RPM for one edge per clock cycle
+   u16 lastPositions[2];          // position counters at the last update
+   volatile u64 odometry[2];      // edges since init, per motor
+   volatile u32 odometryUpdates;  // incremented on every odometry update
 } MotorPosition;
 
+// All the counters, read together
+typedef struct MotorSnapshot {
+   u16 positions[2];              // position counters
+   u16 speedEdges[2];             // edges in the speed window
+   u32 clockCycles;               // length of the speed window
+} MotorSnapshot;
+
 
 /**************************** Type Definitions *****************************/
 
@@ -115,6 +126,12 @@ void MOTOR_POSITION_init(MotorPosition* motorPosition, u32 baseAddr,
 
 void MOTOR_POSITION_get_speeds(MotorPosition* motorPosition, int motor_speed[]);
 
+void MOTOR_POSITION_get_snapshot(MotorPosition* motorPosition,
+      MotorSnapshot* snapshot);
+
+void MOTOR_POSITION_get_snapshot_speeds(MotorPosition* motorPosition,
+      MotorSnapshot* snapshot, int motor_speed[]);
+
 int16_t MOTOR_POSITION_get_distance_traveled(MotorPosition* motorPosition);
 
 void MOTOR_POSITION_get_edge_counts(MotorPosition* motorPosition, int m1[],
@@ -129,4 +146,8 @@ int16_t MOTOR_POSITION_get_position_difference(MotorPosition* motorPosition);
 
 void MOTOR_POSITION_clear_pos_counter(MotorPosition* motorPosition);
 
+void MOTOR_POSITION_update_odometry(MotorPosition* motorPosition);
+
+void MOTOR_POSITION_get_odometry(MotorPosition* motorPosition, u64 edges[]);
+
 #endif // MOTOR_POSITION_H
@@ -0,0 +1,113 @@
+/************************************************************************/
+/*                                                                      */
+/*  pid_controller.c: Fixed point PID controller for the Bot.           */
+/*  This file is part of the Arty S7 Bot Library                        */
+/*                                                                      */
+/************************************************************************/
+
+/*
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+ */
+
+/************************************************************************/
+/*  Module Description:                                                 */
+/*  Integer PID controller with Q16.16 gains, output clamping and       */
+/*  anti-windup. Assumes that PID_CONTROLLER_update gets called at      */
+/*  regular time intervals                                              */
+/*                                                                      */
+/************************************************************************/
+
+#include "pid_controller.h"
+
+/**
+ * void PID_CONTROLLER_init(PIDController * controller, s64 KProportional,
+ *         s64 KIntegral, s64 KDerivative, s32 outputMin, s32 outputMax)
+ *
+ * Configure the controller and reset its errors
+ *
+ * @param controller        PID controller configuration and state
+ * @param KProportional     Q16.16 proportional gain
+ * @param KIntegral         Q16.16 integral gain
+ * @param KDerivative       Q16.16 derivative gain
+ * @param outputMin         lowest output in ticks
+ * @param outputMax         highest output in ticks
+ */
+void PID_CONTROLLER_init(PIDController * controller, s64 KProportional,
+        s64 KIntegral, s64 KDerivative, s32 outputMin, s32 outputMax) {
+    controller->KProportional = KProportional;
+    controller->KIntegral = KIntegral;
+    controller->KDerivative = KDerivative;
+    PID_CONTROLLER_set_limits(controller, outputMin, outputMax);
+    PID_CONTROLLER_reset_errors(controller);
+}
+
+/**
+ * s32 PID_CONTROLLER_update(PIDController * controller, s32 error)
+ *
+ * Compute the new output for the current error. While the output is clamped
+ * the error is not accumulated if it would push the output further out.
+ *
+ * @param controller        PID controller configuration and state
+ * @param error             current error, set point minus measure
+ * @return  output in ticks, between outputMin and outputMax
+ */
+s32 PID_CONTROLLER_update(PIDController * controller, s32 error) {
+    s32 accumulated = controller->accumulated_error + error;
+
+    s64 output = controller->KProportional * error
+            + controller->KIntegral * accumulated
+            + controller->KDerivative * (error - controller->previous_error);
+    output >>= 16;
+
+    if (output > controller->outputMax) {
+        output = controller->outputMax;
+        if (error > 0) {
+            accumulated = controller->accumulated_error;
+        }
+    } else if (output < controller->outputMin) {
+        output = controller->outputMin;
+        if (error < 0) {
+            accumulated = controller->accumulated_error;
+        }
+    }
+
+    controller->accumulated_error = accumulated;
+    controller->previous_error = error;
+    return (s32) output;
+}
+
+/**
+ * void PID_CONTROLLER_set_limits(PIDController * controller, s32 outputMin,
+ *         s32 outputMax)
+ *
+ * Set the output range
+ *
+ * @param controller        PID controller configuration and state
+ * @param outputMin         lowest output in ticks
+ * @param outputMax         highest output in ticks
+ */
+void PID_CONTROLLER_set_limits(PIDController * controller, s32 outputMin,
+        s32 outputMax) {
+    controller->outputMin = outputMin;
+    controller->outputMax = outputMax;
+}
+
+/**
+ * void PID_CONTROLLER_reset_errors(PIDController * controller)
+ *
+ * Reset accumulated errors and previous errors to 0
+ *
+ * @param controller    PID controller configuration and state
+ */
+void PID_CONTROLLER_reset_errors(PIDController * controller) {
+    controller->accumulated_error = 0;
+    controller->previous_error = 0;
+}
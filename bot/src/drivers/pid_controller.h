@@ -0,0 +1,72 @@
+/************************************************************************/
+/*                                                                      */
+/*  pid_controller.h: Fixed point PID controller Header for the Bot.    */
+/*  This file is part of the Arty S7 Bot Library                        */
+/*                                                                      */
+/************************************************************************/
+
+/*
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+ */
+
+/************************************************************************/
+/*  Module Description:                                                 */
+/*  Integer PID controller used by the speed, distance and light        */
+/*  controllers. The MicroBlaze of the Bot has no FPU, so the gains are */
+/*  Q16.16 fixed point and the output is in PWM timer ticks.            */
+/*                                                                      */
+/*  The integral term stops accumulating while the output is clamped    */
+/*  and the error would push it further out (anti-windup).              */
+/*                                                                      */
+/*  Call PID_CONTROLLER_init when creating a new controller             */
+/*                                                                      */
+/*  Call periodically at equal intervals                                */
+/*      PID_CONTROLLER_update                                           */
+/*  to get the new output computed by the controller                    */
+/*                                                                      */
+/*  Call PID_CONTROLLER_set_limits to change the output range           */
+/*                                                                      */
+/*  Call PID_CONTROLLER_reset_errors to reset errors                    */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef PID_CONTROLLER_H
+#define PID_CONTROLLER_H
+
+#include "xil_types.h"
+
+// Q16.16 fixed point value from a double, for gains computed at init. The
+// gains are scaled by the PWM period (10^6 ticks) and can exceed s32
+#define PID_Q16(x) ((s64) ((x) * 65536.0 + ((x) < 0 ? -0.5 : 0.5)))
+
+typedef struct PIDController {
+    s64 KProportional; // Q16.16 output ticks per error unit
+    s64 KIntegral;     // Q16.16 output ticks per accumulated error unit
+    s64 KDerivative;   // Q16.16 output ticks per error change unit
+    s32 outputMin;     // output clamp in ticks
+    s32 outputMax;
+    s32 accumulated_error;
+    s32 previous_error;
+} PIDController;
+
+/************ Function Prototypes ************/
+
+void PID_CONTROLLER_init(PIDController * controller, s64 KProportional,
+        s64 KIntegral, s64 KDerivative, s32 outputMin, s32 outputMax);
+
+s32 PID_CONTROLLER_update(PIDController * controller, s32 error);
+
+void PID_CONTROLLER_set_limits(PIDController * controller, s32 outputMin,
+        s32 outputMax);
+
+void PID_CONTROLLER_reset_errors(PIDController * controller);
+
+#endif // PID_CONTROLLER_H
@@ -0,0 +1,195 @@
+/************************************************************************/
+/*                                                                      */
+/*  pose_estimator.c: Dead reckoning pose estimator for the ArtyBot.    */
+/*  This file is part of the Arty S7 Bot.                               */
+/*                                                                      */
+/************************************************************************/
+
+/*
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+ */
+
+/************************************************************************/
+/*  Module Description:                                                 */
+/*                                                                      */
+/* Differential drive dead reckoning with Q16.16 positions, binary      */
+/* angle headings and a table based sine.                               */
+/*                                                                      */
+/************************************************************************/
+
+#include "pose_estimator.h"
+
+#define PI              3.14159265358979
+#define FULL_TURN       4294967296.0    // binary angle of a full turn
+#define QUARTER_TURN    0x40000000U
+#define MDEG_PER_TURN   360000
+
+// sin(i * 90 / 64 degrees) in Q15, i = 0 to 64
+static const s16 SINE_TABLE[65] = {
+            0,   804,  1608,  2411,  3212,  4011,  4808,  5602,
+         6393,  7180,  7962,  8740,  9512, 10279, 11039, 11793,
+        12540, 13279, 14010, 14733, 15447, 16151, 16846, 17531,
+        18205, 18868, 19520, 20160, 20788, 21403, 22006, 22595,
+        23170, 23732, 24279, 24812, 25330, 25833, 26320, 26791,
+        27246, 27684, 28106, 28511, 28899, 29269, 29622, 29957,
+        30274, 30572, 30853, 31114, 31357, 31581, 31786, 31972,
+        32138, 32286, 32413, 32522, 32610, 32679, 32729, 32758,
+        32767,
+};
+
+static s32 sineQ15(u32 angle);
+static s32 toMdeg(s64 angle);
+
+/**
+ * void POSE_ESTIMATOR_init(PoseEstimator* estimator, double edgesPerCm,
+ *      double wheelBaseCm, u32 updateRateHz, u32 velocityWindow)
+ *
+ * @details initialize the estimator at x = 0, y = 0, heading 0. The
+ *      geometry is converted to fixed point here, the updates are integer
+ *      only
+ *
+ * @param estimator         Pose estimator with actual state reference
+ * @param edgesPerCm        encoder edges per cm traveled by a wheel
+ * @param wheelBaseCm       distance between the wheels
+ * @param updateRateHz      rate POSE_ESTIMATOR_update is called at
+ * @param velocityWindow    number of updates the velocity is averaged over
+ */
+void POSE_ESTIMATOR_init(PoseEstimator* estimator, double edgesPerCm,
+        double wheelBaseCm, u32 updateRateHz, u32 velocityWindow) {
+    double edgeLengthMm = 10.0 / edgesPerCm;
+
+    estimator->halfEdgeLength = edgeLengthMm / 2 * 65536.0 + 0.5;
+    estimator->headingPerEdge = edgeLengthMm / (wheelBaseCm * 10.0)
+            / (2 * PI) * FULL_TURN + 0.5;
+    estimator->updateRateHz = updateRateHz;
+    estimator->velocityWindow = velocityWindow ? velocityWindow : 1;
+    estimator->windowDistance = 0;
+    estimator->windowHeading = 0;
+    estimator->windowCount = 0;
+    estimator->speedMmPerS = 0;
+    estimator->turnRateMdegPerS = 0;
+    estimator->updates = 0;
+    POSE_ESTIMATOR_set_pose(estimator, 0, 0, 0);
+}
+
+/**
+ * void POSE_ESTIMATOR_update(PoseEstimator* estimator, s32 rightEdges,
+ *      s32 leftEdges)
+ *
+ * @details integrate the wheel motion since the previous update. Edges are
+ *      positive when the wheel moves the bot forward. Not reentrant, call
+ *      it from a single context
+ *
+ * @param estimator         Pose estimator with actual state
+ * @param rightEdges        signed edges of the right wheel
+ * @param leftEdges         signed edges of the left wheel
+ */
+void POSE_ESTIMATOR_update(PoseEstimator* estimator, s32 rightEdges,
+        s32 leftEdges) {
+    s32 distance = (rightEdges + leftEdges) * estimator->halfEdgeLength;
+    s32 turn = (rightEdges - leftEdges) * estimator->headingPerEdge;
+
+    if (distance) {
+        // move along the mean heading of the update
+        u32 heading = estimator->heading + turn / 2;
+        estimator->x += ((s64) distance * sineQ15(heading + QUARTER_TURN))
+                >> 15;
+        estimator->y += ((s64) distance * sineQ15(heading)) >> 15;
+    }
+    estimator->heading += turn;
+
+    estimator->windowDistance += distance;
+    estimator->windowHeading += turn;
+    if (++estimator->windowCount >= estimator->velocityWindow) {
+        estimator->speedMmPerS = ((s64) estimator->windowDistance
+                * estimator->updateRateHz / estimator->velocityWindow) >> 16;
+        estimator->turnRateMdegPerS = toMdeg((s64) estimator->windowHeading
+                * estimator->updateRateHz / estimator->velocityWindow);
+        estimator->windowDistance = 0;
+        estimator->windowHeading = 0;
+        estimator->windowCount = 0;
+    }
+    estimator->updates++;
+}
+
+/**
+ * void POSE_ESTIMATOR_set_pose(PoseEstimator* estimator, s32 xMm, s32 yMm,
+ *      s32 headingMdeg)
+ *
+ * @details place the bot at a known pose. Must not run while
+ *      POSE_ESTIMATOR_update does, see DRIVING_DRIVER_set_pose
+ *
+ * @param estimator         Pose estimator with actual state
+ * @param xMm               new x in mm
+ * @param yMm               new y in mm
+ * @param headingMdeg       new heading in millidegrees
+ */
+void POSE_ESTIMATOR_set_pose(PoseEstimator* estimator, s32 xMm, s32 yMm,
+        s32 headingMdeg) {
+    estimator->x = (s64) xMm << 16;
+    estimator->y = (s64) yMm << 16;
+    estimator->heading = (u32) (s64) ((headingMdeg % MDEG_PER_TURN)
+            * (FULL_TURN / MDEG_PER_TURN));
+    estimator->updates++;
+}
+
+/**
+ * void POSE_ESTIMATOR_get_pose(PoseEstimator* estimator, Pose* pose)
+ *
+ * @details copy the actual pose and velocity. Safe to call while
+ *      POSE_ESTIMATOR_update runs from an interrupt, the copy is taken
+ *      again if an update happened in between
+ *
+ * @param estimator         Pose estimator with actual state
+ * @param pose              returns the pose
+ */
+void POSE_ESTIMATOR_get_pose(PoseEstimator* estimator, Pose* pose) {
+    u32 updates;
+    s64 x;
+    s64 y;
+    do {
+        updates = estimator->updates;
+        x = estimator->x;
+        y = estimator->y;
+        pose->heading = estimator->heading;
+        pose->speedMmPerS = estimator->speedMmPerS;
+        pose->turnRateMdegPerS = estimator->turnRateMdegPerS;
+    } while (updates != estimator->updates);
+
+    pose->xMm = x >> 16;
+    pose->yMm = y >> 16;
+    pose->headingMdeg = toMdeg((s32) pose->heading);
+}
+
+/**
+ * Sine of a binary angle in Q15, linear interpolation on a quarter wave
+ */
+static s32 sineQ15(u32 angle) {
+    u32 quadrant = angle >> 30;
+    u32 phase = (angle >> 8) & 0x3FFFFF;    // 22 bits within the quadrant
+    if (quadrant & 1) {
+        phase = 0x400000 - phase;
+    }
+    u32 index = phase >> 16;
+    s32 value = SINE_TABLE[index];
+    if (index < 64) {
+        value += ((SINE_TABLE[index + 1] - value) * (s32) (phase & 0xFFFF))
+                >> 16;
+    }
+    return (quadrant & 2) ? -value : value;
+}
+
+/**
+ * Binary angle to millidegrees
+ */
+static s32 toMdeg(s64 angle) {
+    return (angle * MDEG_PER_TURN) >> 32;
+}
@@ -0,0 +1,76 @@
+/************************************************************************/
+/*                                                                      */
+/*  pose_estimator.h: Dead reckoning pose estimator Header for the Bot. */
+/*  This file is part of the Arty S7 Bot.                               */
+/*                                                                      */
+/************************************************************************/
+
+/*
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+ */
+
+/************************************************************************/
+/*  Module Description:                                                 */
+/*                                                                      */
+/* Differential drive dead reckoning. Integrates the signed edges of    */
+/* each wheel into the position (x, y) and heading of the bot, and      */
+/* estimates its speed and turn rate. Integer only, cheap enough to be  */
+/* updated from the control tick interrupt.                             */
+/*                                                                      */
+/* x points where the bot heads at heading 0, y to its left. Headings   */
+/* grow counterclockwise, as binary angles: 2^32 is a full turn so      */
+/* they wrap around for free.                                           */
+/*                                                                      */
+/*  Call POSE_ESTIMATOR_init, then POSE_ESTIMATOR_update at a fixed     */
+/*  rate with the edges turned by each wheel since the previous call    */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef POSE_ESTIMATOR_H
+#define POSE_ESTIMATOR_H
+
+#include "xil_types.h"
+
+// Pose and velocity of the bot as seen by applications
+typedef struct Pose {
+    s32 xMm;                // position in mm
+    s32 yMm;                // position in mm
+    u32 heading;            // binary angle, 2^32 is a full turn
+    s32 headingMdeg;        // heading in millidegrees -180000 to 179999
+    s32 speedMmPerS;        // forward speed in mm/s
+    s32 turnRateMdegPerS;   // turn rate in millidegrees/s, counterclockwise
+} Pose;
+
+typedef struct PoseEstimator {
+    s32 halfEdgeLength;         // half the wheel travel per edge, Q16.16 mm
+    s32 headingPerEdge;         // heading change per edge of difference
+    u32 updateRateHz;           // rate POSE_ESTIMATOR_update is called at
+    u32 velocityWindow;         // updates the velocity is averaged over
+    volatile s64 x;             // Q16.16 mm
+    volatile s64 y;             // Q16.16 mm
+    volatile u32 heading;       // binary angle
+    volatile s32 speedMmPerS;
+    volatile s32 turnRateMdegPerS;
+    s32 windowDistance;         // Q16.16 mm traveled in the window
+    s32 windowHeading;          // heading change in the window
+    u32 windowCount;            // updates in the window
+    volatile u32 updates;       // incremented on every update
+} PoseEstimator;
+
+void POSE_ESTIMATOR_init(PoseEstimator* estimator, double edgesPerCm,
+        double wheelBaseCm, u32 updateRateHz, u32 velocityWindow);
+void POSE_ESTIMATOR_update(PoseEstimator* estimator, s32 rightEdges,
+        s32 leftEdges);
+void POSE_ESTIMATOR_set_pose(PoseEstimator* estimator, s32 xMm, s32 yMm,
+        s32 headingMdeg);
+void POSE_ESTIMATOR_get_pose(PoseEstimator* estimator, Pose* pose);
+
+#endif // POSE_ESTIMATOR_H
@@ -37,6 +37,16 @@
 
 #include "pwm_driver.h"
 
+// Largest value of the 32 bit timer counters
+#define MAX_COUNT 0xFFFFFFFFU
+// In generate mode the counters add two clocks to every load value
+#define MIN_DUTY_TICKS 2
+
+static int isRunning(PWMDriver* pwmDriver);
+static void start(PWMDriver* pwmDriver);
+static void writeHighTime(PWMDriver* pwmDriver);
+static u32 nsToTicks(PWMDriver* pwmDriver, u32 ns);
+
 /**
  * long PWM_DRIVER_init(PWMDriver* pwmDriver,u16 deviceID,XTmrCtr* timer,
  *      u32 period_ns,double dutyCyclePct,enum PWMState state)
@@ -63,9 +73,7 @@ long PWM_DRIVER_init(
     pwmDriver->timer = timer;
     pwmDriver->period_ns = period_ns;
 
-    pwmDriver->state = state;
-
-    pwmDriver->dutyCyclePct = dutyCyclePct;
+    pwmDriver->state = DISABLED;
 
     /*
      * Initialize the timer counter so that it's ready to use,
@@ -76,7 +84,13 @@ long PWM_DRIVER_init(
         return XST_FAILURE;
     }
 
+    pwmDriver->countDown = XTmrCtr_GetOptions(pwmDriver->timer, 1)
+            & XTC_DOWN_COUNT_OPTION;
+    pwmDriver->periodTicks = nsToTicks(pwmDriver, period_ns);
     PWM_DRIVER_set_duty_pct(pwmDriver, dutyCyclePct);
+    if (state == ENABLED) {
+        PWM_DRIVER_enable(pwmDriver);
+    }
     return 0;
 }
 
@@ -92,27 +106,67 @@ long PWM_DRIVER_init(
  * @param dutyCyclePct   new duty cycle 0.0 to 1.0
  */
 void PWM_DRIVER_set_duty_pct(PWMDriver* pwmDriver, double dutyCyclePct) {
-    u32 highTime;
-
-    if (dutyCyclePct >= 1.0) {
-        dutyCyclePct = 0.99;
-    } else if (dutyCyclePct < 0.0) {
+    if (dutyCyclePct < 0.0) {
         dutyCyclePct = 0.0;
     }
-    pwmDriver->dutyCyclePct = dutyCyclePct;
-    /* Disable PWM for reconfiguration */
-    PWM_DRIVER_disable(pwmDriver);
-    /* Configure PWM */
-    if (pwmDriver->dutyCyclePct > 0.0) {
-        highTime = pwmDriver->period_ns * pwmDriver->dutyCyclePct;
-        XTmrCtr_PwmConfigure(pwmDriver->timer, pwmDriver->period_ns, highTime);
-        /* Enable PWM after reconfiguration */
-        if (pwmDriver->state == ENABLED) {
-            PWM_DRIVER_enable(pwmDriver);
-        }
+    PWM_DRIVER_set_duty_ticks(pwmDriver,
+            dutyCyclePct * pwmDriver->periodTicks);
+}
+
+/**
+ * void PWM_DRIVER_set_duty_ticks(PWMDriver* pwmDriver, u32 dutyTicks)
+ *
+ * @details  Change the PWM duty cycle given as a high time in timer clock
+ *      ticks. Integer only, meant for the control loop.
+ *      While the signal is running only the high time load register is
+ *      written, the new duty cycle takes effect at the next PWM period
+ *      without stopping the signal. A zero duty cycle stops the signal
+ *      until a non zero duty cycle is set again.
+ *
+ * @param pwmDriver      PWM Driver with actual state
+ * @param dutyTicks      new high time 0 to PWM_DRIVER_get_period_ticks
+ */
+void PWM_DRIVER_set_duty_ticks(PWMDriver* pwmDriver, u32 dutyTicks) {
+    int wasRunning = isRunning(pwmDriver);
+
+    if (dutyTicks >= pwmDriver->periodTicks) {
+        dutyTicks = pwmDriver->periodTicks / 100 * 99;
+    } else if (dutyTicks < MIN_DUTY_TICKS) {
+        dutyTicks = 0;
+    }
+    pwmDriver->dutyTicks = dutyTicks;
+
+    if (pwmDriver->state != ENABLED) {
+        return; // loaded by PWM_DRIVER_enable
+    }
+    if (dutyTicks == 0) {
+        XTmrCtr_PwmDisable(pwmDriver->timer);
+    } else if (wasRunning) {
+        writeHighTime(pwmDriver);
+    } else {
+        start(pwmDriver);
     }
 }
 
+/**
+ * void PWM_DRIVER_set_duty_ticks_pair(PWMDriver* first, u32 firstDutyTicks,
+ *      PWMDriver* second, u32 secondDutyTicks)
+ *
+ * @details  Change the duty cycles of two PWM signals, like the two motors,
+ *      in a row. With both signals running this is one register write per
+ *      signal and both take effect at their next PWM period.
+ *
+ * @param first              first PWM Driver with actual state
+ * @param firstDutyTicks     new high time of the first signal
+ * @param second             second PWM Driver with actual state
+ * @param secondDutyTicks    new high time of the second signal
+ */
+void PWM_DRIVER_set_duty_ticks_pair(PWMDriver* first, u32 firstDutyTicks,
+        PWMDriver* second, u32 secondDutyTicks) {
+    PWM_DRIVER_set_duty_ticks(first, firstDutyTicks);
+    PWM_DRIVER_set_duty_ticks(second, secondDutyTicks);
+}
+
 /**
  * PWM_DRIVER_set_period_ns(PWMDriver* pwmDriver, u32 period_ns)
  *
@@ -123,18 +177,16 @@ void PWM_DRIVER_set_duty_pct(PWMDriver* pwmDriver, double dutyCyclePct) {
  * @param period_ns      new pwm signal period in nanoseconds
  */
 void PWM_DRIVER_set_period_ns(PWMDriver* pwmDriver, u32 period_ns){
-    u32 highTime;
+    u32 periodTicks = nsToTicks(pwmDriver, period_ns);
+    /* keep the duty cycle */
+    pwmDriver->dutyTicks = (u64) pwmDriver->dutyTicks * periodTicks
+            / pwmDriver->periodTicks;
     pwmDriver->period_ns = period_ns;
-    /* Disable PWM for reconfiguration */
-    PWM_DRIVER_disable(pwmDriver);
-    /* Configure PWM */
-    if (pwmDriver->dutyCyclePct > 0.0) {
-        highTime = pwmDriver->period_ns * pwmDriver->dutyCyclePct;
-        XTmrCtr_PwmConfigure(pwmDriver->timer, pwmDriver->period_ns, highTime);
-        /* Enable PWM after reconfiguration */
-        if (pwmDriver->state == ENABLED) {
-            PWM_DRIVER_enable(pwmDriver);
-        }
+    pwmDriver->periodTicks = periodTicks;
+    if (isRunning(pwmDriver)) {
+        /* Disable PWM for reconfiguration */
+        XTmrCtr_PwmDisable(pwmDriver->timer);
+        start(pwmDriver);
     }
 }
 
@@ -142,13 +194,19 @@ void PWM_DRIVER_set_period_ns(PWMDriver* pwmDriver, u32 period_ns){
 /**
  * void PWM_DRIVER_enable(PWMDriver* pwmDriver)
  *
- * @details Enable the PWM signal
+ * @details Enable the PWM signal. The signal starts with the actual duty
+ *      cycle, or with the next non zero one
  *
  * @param pwmDriver      PWM Driver with actual state
  */
 void PWM_DRIVER_enable(PWMDriver* pwmDriver) {
+    if (pwmDriver->state == ENABLED) {
+        return;
+    }
     pwmDriver->state = ENABLED;
-    XTmrCtr_PwmEnable(pwmDriver->timer);
+    if (pwmDriver->dutyTicks > 0) {
+        start(pwmDriver);
+    }
 }
 
 
@@ -176,7 +234,7 @@ void PWM_DRIVER_disable(PWMDriver* pwmDriver) {
  * @return  the actual Duty Cycle Percentage 0.0 to 1.0
  */
 double PWM_DRIVER_get_duty_pct(PWMDriver* pwmDriver){
-    return pwmDriver->dutyCyclePct;
+    return (double) pwmDriver->dutyTicks / pwmDriver->periodTicks;
 }
 
 /**
@@ -186,6 +244,47 @@ u32 PWM_DRIVER_get_period_ns(PWMDriver* pwmDriver){
     return pwmDriver->period_ns;
 }
 
+/**
+ * returns the actual Period in timer clock ticks
+ */
+u32 PWM_DRIVER_get_period_ticks(PWMDriver* pwmDriver){
+    return pwmDriver->periodTicks;
+}
+
+/**
+ * The timer generates the signal when enabled with a non zero duty cycle
+ */
+static int isRunning(PWMDriver* pwmDriver) {
+    return pwmDriver->state == ENABLED && pwmDriver->dutyTicks > 0;
+}
 
+/**
+ * Program period and high time and start both counters
+ */
+static void start(PWMDriver* pwmDriver) {
+    u32 highTime = (u64) pwmDriver->period_ns * pwmDriver->dutyTicks
+            / pwmDriver->periodTicks;
+    XTmrCtr_PwmConfigure(pwmDriver->timer, pwmDriver->period_ns, highTime);
+    XTmrCtr_PwmEnable(pwmDriver->timer);
+}
 
+/**
+ * Write the high time to the load register of counter 1, the counter
+ * reloads it at the end of the running period
+ */
+static void writeHighTime(PWMDriver* pwmDriver) {
+    u32 load;
+    if (pwmDriver->countDown) {
+        load = pwmDriver->dutyTicks - 2;
+    } else {
+        load = MAX_COUNT - pwmDriver->dutyTicks + 2;
+    }
+    XTmrCtr_SetResetValue(pwmDriver->timer, 1, load);
+}
 
+/**
+ * Convert nanoseconds to clock ticks of the timer
+ */
+static u32 nsToTicks(PWMDriver* pwmDriver, u32 ns) {
+    return (u64) ns * pwmDriver->timer->Config.SysClockFreqHz / 1000000000;
+}
@@ -48,7 +48,9 @@ typedef struct PWMDriver {
     u16 deviceID;   // AXI device ID
     XTmrCtr* timer; // pointer to the XTmrCtr instance
     u32 period_ns; // period is the period of pwm signal in nano seconds.
-    double dutyCyclePct; // Duty Cycle percentage 0 to 100
+    u32 periodTicks; // period in timer clock ticks
+    u32 dutyTicks; // high time in timer clock ticks, 0 to periodTicks
+    u32 countDown; // the timer counters count down
     enum PWMState state; // Disabled, Enabled
 } PWMDriver;
 
@@ -61,6 +63,10 @@ long PWM_DRIVER_init(
         enum PWMState state);
 
 void PWM_DRIVER_set_duty_pct(PWMDriver* pwmDriver, double dutyCyclePct);
+void PWM_DRIVER_set_duty_ticks(PWMDriver* pwmDriver, u32 dutyTicks);
+void PWM_DRIVER_set_duty_ticks_pair(PWMDriver* first, u32 firstDutyTicks,
+        PWMDriver* second, u32 secondDutyTicks);
+u32 PWM_DRIVER_get_period_ticks(PWMDriver* pwmDriver);
 void PWM_DRIVER_set_period_ns(PWMDriver* pwmDriver, u32 period_ns);
 u32 PWM_DRIVER_get_period_ns(PWMDriver* pwmDriver);
 double PWM_DRIVER_get_duty_pct(PWMDriver* pwmDriver);
@@ -53,98 +53,81 @@
 
 #include "speed_pid_control.h"
 
-
-
 /**
- * SPEED_PID_CONTROLLER_init(SpeedPIDController * controller,
- *  double KProportional, double KIntegral, double KDerivative, double baseDutyCyclePct)
+ * void SPEED_PID_CONTROLLER_init(SpeedPIDController * controller,
+ *         double KProportional, double KIntegral, double KDerivative,
+ *         double baseDutyCyclePct, u32 periodTicks)
  *
- * Uses a PID controller to compute new duty cycles for left and right motors
- * with goal of maintaining rotational motor speeds at speed target and store them in
- * dutyCyclePct. Assumes that this function gets called at regular time intervals
+ * Configure a PID controller per motor to compute new duty cycles with goal of
+ * maintaining rotational motor speeds at speed target.
+ * The gains are given in duty cycle per error unit and stored as Q16.16 PWM
+ * timer ticks, so only the init does floating point.
  *
  * @param controller            Speed PID controller configuration and state
  * @param KProportional         PID proportional term
  * @param KIntegral             PID Integral term
  * @param KDerivative           PID Derivative term
  * @param baseDutyCyclePct      Base duty cycle percentage
+ * @param periodTicks           PWM period in timer ticks
  */
 void SPEED_PID_CONTROLLER_init(SpeedPIDController * controller,
         double KProportional, double KIntegral, double KDerivative,
-        double baseDutyCyclePct) {
-
-    controller->KProportional = KProportional;
-    controller->KIntegral = KIntegral;
-    controller->KDerivative = KDerivative;
-    controller->baseDutyCyclePct = baseDutyCyclePct;
-
+        double baseDutyCyclePct, u32 periodTicks) {
+
+    controller->periodTicks = periodTicks;
+    for (int i = 0; i < 2; i++) {
+        PID_CONTROLLER_init(&controller->pid[i],
+                PID_Q16(KProportional * periodTicks),
+                PID_Q16(KIntegral * periodTicks),
+                PID_Q16(KDerivative * periodTicks), 0, 0);
+    }
+    SPEED_PID_CONTROLLER_set_duty_cycle(controller, baseDutyCyclePct);
 }
 
-
 /**
- * void SPEED_PID_CONTROLLER_set_duty_cycle(DistancePIDController * controller,
+ * void SPEED_PID_CONTROLLER_set_duty_cycle(SpeedPIDController * controller,
  *       double baseDutyCyclePct)
  *
  * Set the new base duty cycle
  *
- * @param controller        Distance PID controller configuration and state
+ * @param controller        Speed PID controller configuration and state
  * @param baseDutyCyclePct  Base duty cycle percentage 0.4 typical 0.75 for fast speed
  */
 void SPEED_PID_CONTROLLER_set_duty_cycle(SpeedPIDController * controller,
         double baseDutyCyclePct) {
-    controller->baseDutyCyclePct = baseDutyCyclePct;
+    s32 base = baseDutyCyclePct * controller->periodTicks;
+    s32 period = controller->periodTicks;
+    controller->baseDutyTicks = base;
+    // base plus correction stays between 0 and the period
+    PID_CONTROLLER_set_limits(&controller->pid[0], -base, period - base);
+    PID_CONTROLLER_set_limits(&controller->pid[1], -base, period - base);
 }
 
-
 /**
- * void SPEED_PID_CONTROLLER_get_new_outputs(
- *      SpeedPIDController * controller, int pos_diff, double dutyCyclePct[])
+ * void SPEED_PID_CONTROLLER_get_new_outputs(SpeedPIDController * controller,
+ *      int speedTargetRpm, int speedsRpm[], u32 dutyTicks[])
  *
- *  Uses a PID controller to compute new duty cycles for the right motor and the left motor
- *  with goal of minimizing position difference to 0 and store them in duty_cycle.
+ *  Uses a PID controller per motor to compute new duty cycles for the right
+ *  motor and the left motor with goal of maintaining rotational motor speeds
+ *  at speed target and store them in dutyTicks.
  *  Assumes that this function gets called at regular time intervals
  *
  * @param controller        Speed PID controller configuration and state
  * @param speedTargetRpm    Speed set point (desired speed) in RPM
  * @param speedsRpm         Array with current speeds of right motor, left motor, respectively
- * @param dutyCyclePct      Array for storing new percentage duty cycles for right motor
- *                          and left motor respectively. Values from 0.0 to 1.0
+ * @param dutyTicks         Array for storing new duty cycles for right motor
+ *                          and left motor respectively, in PWM timer ticks
+ *                          from 0 to the period
  */
 void SPEED_PID_CONTROLLER_get_new_outputs(SpeedPIDController * controller,
-        int speedTargetRpm, int speedsRpm[], double dutyCyclePct[]) {
-
-    int err_m1 = speedTargetRpm - speedsRpm[0]; // Current error
-    int err_m2 = speedTargetRpm - speedsRpm[1];
-
-    controller->accumulated_error[0] += err_m1; // Accumulated error
-    controller->accumulated_error[1] += err_m2;
-
-    dutyCyclePct[0] = controller->baseDutyCyclePct;
-    dutyCyclePct[1] = controller->baseDutyCyclePct;
-
-    dutyCyclePct[0] += controller->KProportional * err_m1
-            + controller->KIntegral * controller->accumulated_error[0]
-            + controller->KDerivative
-                    * (err_m1 - controller->previous_error[0]);
-
-    dutyCyclePct[1] += controller->KProportional * err_m2
-            + controller->KIntegral * controller->accumulated_error[1]
-            + controller->KDerivative
-                    * (err_m2 - controller->previous_error[1]);
-
-    // Bound duty cycles between 0 and 1
-    if (dutyCyclePct[0] < 0.0) {
-        dutyCyclePct[0] = 0.0;
-    } else if (dutyCyclePct[0] > 1.0) {
-        dutyCyclePct[0] = 1.0;
-    }
-
-    if (dutyCyclePct[1] < 0.0) {
-        dutyCyclePct[1] = 0.0;
-    } else if (dutyCyclePct[1] > 1.0) {
-        dutyCyclePct[1] = 1.0;
-    }
-
+        int speedTargetRpm, int speedsRpm[], u32 dutyTicks[]) {
+
+    dutyTicks[0] = controller->baseDutyTicks
+            + PID_CONTROLLER_update(&controller->pid[0],
+                    speedTargetRpm - speedsRpm[0]);
+    dutyTicks[1] = controller->baseDutyTicks
+            + PID_CONTROLLER_update(&controller->pid[1],
+                    speedTargetRpm - speedsRpm[1]);
 }
 
 /**
@@ -155,10 +138,6 @@ void SPEED_PID_CONTROLLER_get_new_outputs(SpeedPIDController * controller,
  * @param controller    Speed PID controller configuration and state
  */
 void SPEED_PID_CONTROLLER_reset_errors(SpeedPIDController * controller) {
-    controller->previous_error[0] = 0;
-    controller->previous_error[1] = 0;
-
-    controller->accumulated_error[0] = 0;
-    controller->accumulated_error[1] = 0;
-
+    PID_CONTROLLER_reset_errors(&controller->pid[0]);
+    PID_CONTROLLER_reset_errors(&controller->pid[1]);
 }
@@ -48,23 +48,22 @@
 #ifndef SPEED_PID_CONTROLLER_H
 #define SPEED_PID_CONTROLLER_H
 
+#include "pid_controller.h"
+
 typedef struct SpeedPIDController {
-    double KProportional;
-    double KIntegral;
-    double KDerivative;
-    int accumulated_error[2];
-    int previous_error[2];
-    double baseDutyCyclePct;
+    PIDController pid[2];
+    u32 baseDutyTicks;
+    u32 periodTicks;
 } SpeedPIDController;
 
 /************ Function Prototypes ************/
 
 void SPEED_PID_CONTROLLER_init(SpeedPIDController * controller,
         double KProportional, double KIntegral, double KDerivative,
-        double baseDutyCyclePct);
+        double baseDutyCyclePct, u32 periodTicks);
 
 void SPEED_PID_CONTROLLER_get_new_outputs(SpeedPIDController * controller,
-        int speedTargetRpm, int speedsRpm[], double dutyCyclePct[]);
+        int speedTargetRpm, int speedsRpm[], u32 dutyTicks[]);
 
 void SPEED_PID_CONTROLLER_reset_errors(SpeedPIDController * controller);
 
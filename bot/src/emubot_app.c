@@ -151,38 +151,49 @@ void emu_bot_application() {
             OLED_SetCursor(&botDrivers.oled, 0, 0);
             sleep(1);
             for (int i = 0; i < actions_number; ++i) {
-                if (BUTTONS_DRIVER_button1_pressed(&botDrivers.buttonsDriver)) {
-                    actions_number = 0;
-                    OLED_Clear(&botDrivers.oled);
-                    OLED_SetCursor(&botDrivers.oled, 0, 3);
-                    OLED_PutString(&botDrivers.oled, "     CANCEL");
-                    sleep(1);
-                    break;
-                }
                 if (bot_actions[i] == 'L') {
                     LEDS_DRIVER_set_led1_on(&botDrivers.ledsDriver);
                     OLED_PutChar(&botDrivers.oled, CHAR_LEFT);
-                    //usleep(50000);
-                    DRIVING_DRIVER_turn_left_degrees(&botDrivers.drivingDriver,
-                            90);
-                    LEDS_DRIVER_set_led1_off(&botDrivers.ledsDriver);
+                    DRIVING_DRIVER_queue_command(&botDrivers.drivingDriver,
+                            MOTION_CMD_TURN_LEFT, 90);
                 }
                 if (bot_actions[i] == 'R') {
-
                     LEDS_DRIVER_set_led3_on(&botDrivers.ledsDriver);
                     OLED_PutChar(&botDrivers.oled, CHAR_RIGHT);
-                    //usleep(50000);
-                    DRIVING_DRIVER_turn_right_degrees(&botDrivers.drivingDriver,
-                            90);
-                    LEDS_DRIVER_set_led3_off(&botDrivers.ledsDriver);
+                    DRIVING_DRIVER_queue_command(&botDrivers.drivingDriver,
+                            MOTION_CMD_TURN_RIGHT, 90);
                 }
                 if (bot_actions[i] == 'F') {
                     LEDS_DRIVER_set_led2_on(&botDrivers.ledsDriver);
                     OLED_PutChar(&botDrivers.oled, CHAR_FORWARD);
-                    //usleep(50000);
-                    DRIVING_DRIVER_drive_forward_cm(&botDrivers.drivingDriver,
-                            18);
-                    LEDS_DRIVER_set_led2_off(&botDrivers.ledsDriver);
+                    DRIVING_DRIVER_queue_command(&botDrivers.drivingDriver,
+                            MOTION_CMD_FORWARD, 18);
+                }
+                u32 command = DRIVING_DRIVER_queue_command(
+                        &botDrivers.drivingDriver, MOTION_CMD_STOP, 0);
+
+                // the bot drives while the cancel button is polled
+                int canceled = 0;
+                while (!DRIVING_DRIVER_command_done(&botDrivers.drivingDriver,
+                        command)) {
+                    if (BUTTONS_DRIVER_button1_pressed(
+                            &botDrivers.buttonsDriver)) {
+                        DRIVING_DRIVER_cancel_commands(
+                                &botDrivers.drivingDriver);
+                        canceled = 1;
+                    }
+                }
+                LEDS_DRIVER_set_led1_off(&botDrivers.ledsDriver);
+                LEDS_DRIVER_set_led2_off(&botDrivers.ledsDriver);
+                LEDS_DRIVER_set_led3_off(&botDrivers.ledsDriver);
+
+                if (canceled) {
+                    actions_number = 0;
+                    OLED_Clear(&botDrivers.oled);
+                    OLED_SetCursor(&botDrivers.oled, 0, 3);
+                    OLED_PutString(&botDrivers.oled, "     CANCEL");
+                    sleep(1);
+                    break;
                 }
             }
         }
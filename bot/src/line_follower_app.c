@@ -110,7 +110,8 @@ void line_follower_application() {
         LIGHT_PID_CONTROLLER_init(botDrivers.drivingDriver.lightPIDController,
         BOT_LIGHT_PID_K_PROPORTIONAL,
         BOT_LIGHT_PID_K_INTEGRAL,
-        BOT_LIGHT_PID_K_DERIVATIVE, .10);
+        BOT_LIGHT_PID_K_DERIVATIVE, .10,
+        PWM_DRIVER_get_period_ticks(botDrivers.drivingDriver.pwmRightMotor));
 
         while (SWITCHES_DRIVER_poll_switch2(&botDrivers.switchesDriver)) {
             DRIVING_DRIVER_drive_forward_continuous_light(
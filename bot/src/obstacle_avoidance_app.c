@@ -49,7 +49,7 @@ void obstacle_avoidance_application() {
 
     BOT_init(&botDrivers);
     sleep(1);
-    PmodToF_Initialize();
+    BOT_init_distance_sensor();
 
     OLED_SetCharUpdate(&botDrivers.oled, 0);
     OLED_ClearBuffer(&botDrivers.oled);
@@ -0,0 +1,72 @@
+/**
+ *
+ * frame_allocator.c: Display framebuffers sized from the video mode.
+ *
+ */
+
+/***************************** Include Files *******************************/
+#include "frame_allocator.h"
+
+/************************** Function Definitions ***************************/
+
+/**
+ * void FRAME_ALLOCATOR_init(FrameAllocator *alloc, void *region, u32 size,
+ *      u8 firstBank)
+ *
+ * @details initialize an allocator over a region, without framebuffers
+ *
+ * @param alloc     allocator state
+ * @param region    DDR memory for the framebuffers
+ * @param size      region size in bytes, see FRAME_ALLOCATOR_REGION_SIZE
+ * @param firstBank DDR bank of the first framebuffer, the next ones take
+ *                  the following banks. Give allocators whose framebuffers
+ *                  are used together different banks
+ */
+void FRAME_ALLOCATOR_init(FrameAllocator *alloc, void *region, u32 size,
+        u8 firstBank) {
+    int i;
+
+    alloc->base = (UINTPTR) region;
+    alloc->size = size;
+    alloc->firstBank = firstBank % FRAME_ALLOCATOR_DDR_BANKS;
+    alloc->stride = 0;
+    for (i = 0; i < DISPLAY_NUM_FRAMES; i++) {
+        alloc->frames[i] = NULL;
+    }
+}
+
+/**
+ * int FRAME_ALLOCATOR_alloc(FrameAllocator *alloc, const VideoMode *mode)
+ *
+ * @details lay out the framebuffers of a video mode in the region, replacing
+ *      the previous ones. Their content is left as it was
+ *
+ * @param alloc allocator state, frames and stride are set on success
+ * @param mode  video mode to size the framebuffers for
+ * @return 0, -1 if the framebuffers do not fit in the region
+ */
+int FRAME_ALLOCATOR_alloc(FrameAllocator *alloc, const VideoMode *mode) {
+    UINTPTR end = alloc->base + alloc->size;
+    UINTPTR next = alloc->base;
+    UINTPTR frame[DISPLAY_NUM_FRAMES];
+    u32 stride = FRAME_ALLOCATOR_STRIDE(mode->width);
+    u32 bytes = stride * mode->height;
+    u32 bank;
+    int i;
+
+    for (i = 0; i < DISPLAY_NUM_FRAMES; i++) {
+        bank = (alloc->firstBank + i) % FRAME_ALLOCATOR_DDR_BANKS;
+        frame[i] = FRAME_ALLOCATOR_ALIGN(next, FRAME_ALLOCATOR_BANK_PERIOD)
+                + bank * FRAME_ALLOCATOR_DDR_PAGE;
+        if (frame[i] + bytes > end) {
+            return -1;
+        }
+        next = frame[i] + bytes;
+    }
+
+    alloc->stride = stride;
+    for (i = 0; i < DISPLAY_NUM_FRAMES; i++) {
+        alloc->frames[i] = (void *) frame[i];
+    }
+    return 0;
+}
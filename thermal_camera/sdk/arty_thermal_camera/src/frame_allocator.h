@@ -0,0 +1,63 @@
+/**
+ *
+ * frame_allocator.h: Display framebuffers sized from the video mode.
+ *
+ * An allocator lays out the DISPLAY_NUM_FRAMES framebuffers of one video mode
+ * in a region of DDR. The line stride is the active width rounded up to
+ * whole VDMA MM2S bursts, so every line starts a new burst.
+ *
+ * The DDR3 of the Arty S7 (MT41K128M16, ROW_BANK_COLUMN mapping in the MIG)
+ * has 2 KB pages spread over 8 banks, so consecutive pages fall in
+ * consecutive banks. Each framebuffer starts in its own bank: the same line
+ * of the front and back buffers are then always in different banks, and the
+ * VDMA reading one while the CPU renders the other keep their own rows open
+ * instead of closing each other's.
+ *
+ * Call FRAME_ALLOCATOR_init once for a region, then FRAME_ALLOCATOR_alloc
+ * each time the region is reused for a video mode.
+ *
+ */
+
+#ifndef FRAME_ALLOCATOR_H
+#define FRAME_ALLOCATOR_H
+
+/****************** Include Files ********************/
+#include "xil_types.h"
+#include "xparameters.h"
+#include "zybo_vga/display_ctrl.h"
+
+#define FRAME_ALLOCATOR_BURST_BEATS 16
+#define FRAME_ALLOCATOR_BURST_BYTES \
+    (XPAR_AXIVDMA_0_M_AXI_MM2S_DATA_WIDTH / 8 * FRAME_ALLOCATOR_BURST_BEATS)
+
+#define FRAME_ALLOCATOR_DDR_PAGE 2048
+#define FRAME_ALLOCATOR_DDR_BANKS 8
+#define FRAME_ALLOCATOR_BANK_PERIOD \
+    (FRAME_ALLOCATOR_DDR_PAGE * FRAME_ALLOCATOR_DDR_BANKS)
+
+#define FRAME_ALLOCATOR_ALIGN(size, align) \
+    (((size) + (align) - 1) / (align) * (align))
+
+#define FRAME_ALLOCATOR_STRIDE(width) \
+    FRAME_ALLOCATOR_ALIGN((width) * 4, FRAME_ALLOCATOR_BURST_BYTES)
+
+// bytes of a region that fits the framebuffers of a width x height mode,
+// including the padding to place them on their banks
+#define FRAME_ALLOCATOR_REGION_SIZE(width, height) \
+    (DISPLAY_NUM_FRAMES * (FRAME_ALLOCATOR_STRIDE(width) * (height) \
+            + 2 * FRAME_ALLOCATOR_BANK_PERIOD) + FRAME_ALLOCATOR_BANK_PERIOD)
+
+typedef struct FrameAllocator {
+    UINTPTR base;       // region in DDR
+    u32 size;
+    u8 firstBank;       // bank of the first framebuffer
+    u32 stride;         // line stride in bytes of the current mode
+    void *frames[DISPLAY_NUM_FRAMES];
+} FrameAllocator;
+
+void FRAME_ALLOCATOR_init(FrameAllocator *alloc, void *region, u32 size,
+        u8 firstBank);
+
+int FRAME_ALLOCATOR_alloc(FrameAllocator *alloc, const VideoMode *mode);
+
+#endif // FRAME_ALLOCATOR_H
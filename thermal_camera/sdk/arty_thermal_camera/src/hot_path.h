@@ -0,0 +1,51 @@
+/**
+ *
+ * hot_path.h: Placement of the per pixel kernels and tables in the
+ * MicroBlaze local memory (LMB BRAM).
+ *
+ * Code and data tagged with these attributes are linked by lscript.ld into
+ * the LMB BRAM instead of DDR, where they do not compete for the 16 KB
+ * data cache with the framebuffer writes. The libgcc soft float and
+ * integer multiply/divide routines and sqrt are placed there too.
+ *
+ * HOT_PATH_PRINT_USAGE() prints the LMB BRAM usage from the lscript.ld
+ * symbols, main calls it at start-up. This is the BRAM usage report, the
+ * build does not print one.
+ *
+ */
+
+#ifndef HOT_PATH_H
+#define HOT_PATH_H
+
+#ifdef __MICROBLAZE__
+
+#include "xil_printf.h"
+
+#define HOT_PATH_TEXT   __attribute__((section(".lmb_text")))
+#define HOT_PATH_DATA   __attribute__((section(".lmb_data")))
+#define HOT_PATH_RODATA __attribute__((section(".lmb_rodata")))
+
+// symbols defined in lscript.ld
+extern char __lmb_text_start[];
+extern char __lmb_text_end[];
+extern char __lmb_data_start[];
+extern char __lmb_data_end[];
+extern char __lmb_size[];
+
+#define HOT_PATH_PRINT_USAGE() \
+    xil_printf("LMB BRAM: code %d, data %d of %d bytes\r\n", \
+            (int) (__lmb_text_end - __lmb_text_start), \
+            (int) (__lmb_data_end - __lmb_data_start), \
+            (int) (UINTPTR) __lmb_size)
+
+#else
+
+#define HOT_PATH_TEXT
+#define HOT_PATH_DATA
+#define HOT_PATH_RODATA
+
+#define HOT_PATH_PRINT_USAGE()
+
+#endif
+
+#endif // HOT_PATH_H
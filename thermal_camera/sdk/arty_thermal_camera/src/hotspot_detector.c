@@ -0,0 +1,262 @@
+/**
+ *
+ * hotspot_detector.c: Hot spot detector for the MLX90640 32x24 array.
+ *
+ * Single pass connected component labelling: every hot pixel takes the
+ * label of an already visited hot neighbour (west, north and, with
+ * 8-connectivity, north-west and north-east) or a new one. Labels that
+ * meet are merged with union-find and their statistics are merged with
+ * them, so no second pass over the pixels is needed.
+ *
+ */
+
+/***************************** Include Files *******************************/
+#include "hotspot_detector.h"
+
+/************************** Local Functions Prototypes ***********************/
+
+static u16 HOTSPOT_DETECTOR_find(HotSpotDetector* detector, u16 label);
+static u16 HOTSPOT_DETECTOR_union(HotSpotDetector* detector, u16 a, u16 b);
+static void HOTSPOT_DETECTOR_report(HotSpotDetector* detector, u16 label);
+
+/************************** Function Definitions ***************************/
+
+/**
+ * void HOTSPOT_DETECTOR_init(HotSpotDetector* detector, s16 threshold,
+ *      u16 minArea, HotSpotConnectivity connectivity)
+ *
+ * @details initialize the detector
+ *
+ * @param detector      detector state
+ * @param threshold     pixels above this temperature in centi-degrees are hot
+ * @param minArea       hot spots with fewer pixels are discarded
+ * @param connectivity  HOTSPOT_CONNECTIVITY_4 or HOTSPOT_CONNECTIVITY_8
+ */
+void HOTSPOT_DETECTOR_init(HotSpotDetector* detector, s16 threshold,
+        u16 minArea, HotSpotConnectivity connectivity) {
+    detector->threshold = threshold;
+    detector->minArea = minArea > 0 ? minArea : 1;
+    detector->connectivity = connectivity;
+    detector->spotCount = 0;
+}
+
+/**
+ * void HOTSPOT_DETECTOR_set_threshold(HotSpotDetector* detector,
+ *      s16 threshold)
+ *
+ * @param detector      detector state
+ * @param threshold     pixels above this temperature in centi-degrees are hot
+ */
+void HOTSPOT_DETECTOR_set_threshold(HotSpotDetector* detector, s16 threshold) {
+    detector->threshold = threshold;
+}
+
+/**
+ * u16 HOTSPOT_DETECTOR_detect(HotSpotDetector* detector, const int16_t *to)
+ *
+ * @details label the hot pixels of a full To frame and update the list of
+ *      hot spots in detector->spots
+ *
+ * @param detector  detector state
+ * @param to        object temperatures in centi-degrees from
+ *                  MLX90640_CalculateToCenti
+ * @return the number of hot spots found
+ */
+u16 HOTSPOT_DETECTOR_detect(HotSpotDetector* detector, const int16_t *to) {
+    const s16 threshold = detector->threshold;
+    const int eightConnected = detector->connectivity
+            == HOTSPOT_CONNECTIVITY_8;
+    u16 *label = detector->label;
+    u16 labelCount = 0;
+    u16 current;
+    u16 neighbour;
+    HotSpot *stats;
+    s16 value;
+    int line;
+    int column;
+    int p = 0;
+
+    detector->spotCount = 0;
+
+    for (line = 0; line < MLX90640_LINE_NUM; line++) {
+        for (column = 0; column < MLX90640_COLUMN_NUM; column++, p++) {
+            if (to[p] <= threshold) {
+                label[p] = 0;
+                continue;
+            }
+
+            current = 0;
+            if (column > 0) {
+                current = label[p - 1];
+            }
+            if (line > 0) {
+                neighbour = label[p - MLX90640_COLUMN_NUM];
+                if (neighbour != 0) {
+                    current = current ?
+                            HOTSPOT_DETECTOR_union(detector, current,
+                                    neighbour) : neighbour;
+                }
+                if (eightConnected && column > 0) {
+                    neighbour = label[p - MLX90640_COLUMN_NUM - 1];
+                    if (neighbour != 0) {
+                        current = current ?
+                                HOTSPOT_DETECTOR_union(detector, current,
+                                        neighbour) : neighbour;
+                    }
+                }
+                if (eightConnected && column < MLX90640_COLUMN_NUM - 1) {
+                    neighbour = label[p - MLX90640_COLUMN_NUM + 1];
+                    if (neighbour != 0) {
+                        current = current ?
+                                HOTSPOT_DETECTOR_union(detector, current,
+                                        neighbour) : neighbour;
+                    }
+                }
+            }
+
+            value = to[p];
+
+            if (current == 0) {
+                current = ++labelCount;
+                detector->parent[current - 1] = current;
+                stats = &detector->stats[current - 1];
+                stats->area = 0;
+                stats->peak = value;
+                stats->peakPixel = p;
+                stats->left = column;
+                stats->right = column;
+                stats->top = line;
+                stats->bottom = line;
+                detector->sumX[current - 1] = 0;
+                detector->sumY[current - 1] = 0;
+            } else {
+                current = HOTSPOT_DETECTOR_find(detector, current);
+                stats = &detector->stats[current - 1];
+                if (value > stats->peak) {
+                    stats->peak = value;
+                    stats->peakPixel = p;
+                }
+                if (column < stats->left) {
+                    stats->left = column;
+                }
+                if (column > stats->right) {
+                    stats->right = column;
+                }
+                stats->bottom = line;
+            }
+
+            stats->area++;
+            detector->sumX[current - 1] += column;
+            detector->sumY[current - 1] += line;
+            label[p] = current;
+        }
+    }
+
+    for (current = 1; current <= labelCount; current++) {
+        if (detector->parent[current - 1] == current) {
+            HOTSPOT_DETECTOR_report(detector, current);
+        }
+    }
+
+    return detector->spotCount;
+}
+
+/**
+ * static u16 HOTSPOT_DETECTOR_find(HotSpotDetector* detector, u16 label)
+ *
+ * @details find the root label with path halving
+ */
+static u16 HOTSPOT_DETECTOR_find(HotSpotDetector* detector, u16 label) {
+    u16 *parent = detector->parent;
+
+    while (parent[label - 1] != label) {
+        parent[label - 1] = parent[parent[label - 1] - 1];
+        label = parent[label - 1];
+    }
+    return label;
+}
+
+/**
+ * static u16 HOTSPOT_DETECTOR_union(HotSpotDetector* detector, u16 a, u16 b)
+ *
+ * @details merge the components of labels a and b into the lowest root,
+ *      merging their statistics
+ *
+ * @return the root label
+ */
+static u16 HOTSPOT_DETECTOR_union(HotSpotDetector* detector, u16 a, u16 b) {
+    HotSpot *root;
+    HotSpot *merged;
+    u16 swap;
+
+    a = HOTSPOT_DETECTOR_find(detector, a);
+    b = HOTSPOT_DETECTOR_find(detector, b);
+    if (a == b) {
+        return a;
+    }
+    if (b < a) {
+        swap = a;
+        a = b;
+        b = swap;
+    }
+
+    detector->parent[b - 1] = a;
+    root = &detector->stats[a - 1];
+    merged = &detector->stats[b - 1];
+
+    root->area += merged->area;
+    detector->sumX[a - 1] += detector->sumX[b - 1];
+    detector->sumY[a - 1] += detector->sumY[b - 1];
+    if (merged->peak > root->peak) {
+        root->peak = merged->peak;
+        root->peakPixel = merged->peakPixel;
+    }
+    if (merged->left < root->left) {
+        root->left = merged->left;
+    }
+    if (merged->right > root->right) {
+        root->right = merged->right;
+    }
+    if (merged->top < root->top) {
+        root->top = merged->top;
+    }
+    if (merged->bottom > root->bottom) {
+        root->bottom = merged->bottom;
+    }
+    return a;
+}
+
+/**
+ * static void HOTSPOT_DETECTOR_report(HotSpotDetector* detector, u16 label)
+ *
+ * @details insert a finished component in the list of hot spots,
+ *      keeping the HOTSPOT_MAX_SPOTS largest ones
+ */
+static void HOTSPOT_DETECTOR_report(HotSpotDetector* detector, u16 label) {
+    HotSpot *stats = &detector->stats[label - 1];
+    HotSpot *spots = detector->spots;
+    int i;
+
+    if (stats->area < detector->minArea) {
+        return;
+    }
+
+    i = detector->spotCount;
+    if (i == HOTSPOT_MAX_SPOTS) {
+        if (spots[i - 1].area >= stats->area) {
+            return;
+        }
+        i--;
+    } else {
+        detector->spotCount++;
+    }
+
+    while (i > 0 && spots[i - 1].area < stats->area) {
+        spots[i] = spots[i - 1];
+        i--;
+    }
+
+    spots[i] = *stats;
+    spots[i].centroidX = (detector->sumX[label - 1] << 8) / stats->area;
+    spots[i].centroidY = (detector->sumY[label - 1] << 8) / stats->area;
+}
@@ -0,0 +1,65 @@
+/**
+ *
+ * hotspot_detector.h: Hot spot detector for the MLX90640 32x24 array.
+ *
+ * Thresholds the object temperatures and labels the 4 or 8 connected
+ * components in a single raster pass with union-find. For every component
+ * it reports area, centroid, peak temperature and bounding box, computed
+ * in integer arithmetic, so the blob list can be sent instead of frames.
+ *
+ * Call HOTSPOT_DETECTOR_init once, then HOTSPOT_DETECTOR_detect after
+ * each MLX90640_CalculateToCenti.
+ *
+ */
+
+#ifndef HOTSPOT_DETECTOR_H
+#define HOTSPOT_DETECTOR_H
+
+/****************** Include Files ********************/
+#include "xil_types.h"
+#include "mlx90640_api.h"
+
+// maximum number of hot spots reported, the largest ones are kept
+#define HOTSPOT_MAX_SPOTS 16
+
+// worst case number of provisional labels, a checkerboard of hot pixels
+#define HOTSPOT_MAX_LABELS (MLX90640_PIXEL_NUM / 2)
+
+typedef enum HotSpotConnectivity {
+    HOTSPOT_CONNECTIVITY_4 = 4, HOTSPOT_CONNECTIVITY_8 = 8
+} HotSpotConnectivity;
+
+typedef struct HotSpot {
+    u16 area;       // number of pixels
+    u16 centroidX;  // column of the centroid, Q8
+    u16 centroidY;  // line of the centroid, Q8
+    s16 peak;       // highest temperature in centi-degrees
+    u16 peakPixel;  // pixel number of the highest temperature
+    u8 left;        // bounding box, inclusive
+    u8 top;
+    u8 right;
+    u8 bottom;
+} HotSpot;
+
+typedef struct HotSpotDetector {
+    s16 threshold;          // hot pixel threshold in centi-degrees
+    u16 minArea;            // smaller components are discarded
+    HotSpotConnectivity connectivity;
+    u16 spotCount;          // hot spots found in the last frame
+    HotSpot spots[HOTSPOT_MAX_SPOTS]; // sorted by decreasing area
+    // labelling work area
+    u16 label[MLX90640_PIXEL_NUM];   // provisional label + 1, 0 = background
+    u16 parent[HOTSPOT_MAX_LABELS];
+    u32 sumX[HOTSPOT_MAX_LABELS];
+    u32 sumY[HOTSPOT_MAX_LABELS];
+    HotSpot stats[HOTSPOT_MAX_LABELS];
+} HotSpotDetector;
+
+void HOTSPOT_DETECTOR_init(HotSpotDetector* detector, s16 threshold,
+        u16 minArea, HotSpotConnectivity connectivity);
+
+void HOTSPOT_DETECTOR_set_threshold(HotSpotDetector* detector, s16 threshold);
+
+u16 HOTSPOT_DETECTOR_detect(HotSpotDetector* detector, const int16_t *to);
+
+#endif // HOTSPOT_DETECTOR_H
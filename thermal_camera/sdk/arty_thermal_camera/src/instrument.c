@@ -0,0 +1,253 @@
+/**
+ *
+ * instrument.c: Stage timing probes for the thermal camera pipeline.
+ *
+ */
+
+/***************************** Include Files *******************************/
+#include "instrument.h"
+#include "hot_path.h"
+
+#if defined(XPAR_TMRCTR_0_BASEADDR)
+#include "xtmrctr_l.h"
+#endif
+
+#ifdef __MICROBLAZE__
+#include "xil_printf.h"
+#include "xuartlite_l.h"
+#define INSTRUMENT_PRINTF xil_printf
+#else
+#include <stdio.h>
+#include <time.h>
+#define INSTRUMENT_PRINTF printf
+#endif
+
+/************************** Variable Definitions ***************************/
+
+static InstrumentProbe probes[INSTRUMENT_MAX_PROBES];
+static u8 probeCount;
+
+/************************** Local Functions Prototypes ***********************/
+
+static void INSTRUMENT_clear(InstrumentProbe *probe);
+static u32 INSTRUMENT_to_us(u32 ticks);
+
+/************************** Function Definitions ***************************/
+
+/**
+ * void INSTRUMENT_init(void)
+ *
+ * @details start the free-running counter and remove all the probes
+ */
+void INSTRUMENT_init(void) {
+#if defined(XPAR_TMRCTR_0_BASEADDR)
+    XTmrCtr_SetControlStatusReg(XPAR_TMRCTR_0_BASEADDR, 0, 0);
+    XTmrCtr_SetLoadReg(XPAR_TMRCTR_0_BASEADDR, 0, 0);
+    XTmrCtr_LoadTimerCounterReg(XPAR_TMRCTR_0_BASEADDR, 0);
+    XTmrCtr_SetControlStatusReg(XPAR_TMRCTR_0_BASEADDR, 0,
+            XTC_CSR_ENABLE_TMR_MASK | XTC_CSR_AUTO_RELOAD_MASK);
+#endif
+    probeCount = 0;
+}
+
+/**
+ * int INSTRUMENT_probe(const char *name)
+ *
+ * @details add a probe
+ *
+ * @param name  probe name shown in the report, not copied
+ * @return the probe handle or -1 if there is no probe left
+ */
+int INSTRUMENT_probe(const char *name) {
+    if (probeCount == INSTRUMENT_MAX_PROBES) {
+        return -1;
+    }
+    probes[probeCount].name = name;
+    INSTRUMENT_clear(&probes[probeCount]);
+    return probeCount++;
+}
+
+/**
+ * u32 INSTRUMENT_now(void)
+ *
+ * @return the free-running counter in ticks of 1 / INSTRUMENT_CLOCK_HZ,
+ *      0 without time base
+ */
+HOT_PATH_TEXT u32 INSTRUMENT_now(void) {
+#if defined(XPAR_TMRCTR_0_BASEADDR)
+    return XTmrCtr_GetTimerCounterReg(XPAR_TMRCTR_0_BASEADDR, 0);
+#elif !defined(__MICROBLAZE__)
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u32) now.tv_sec * 1000000000UL + (u32) now.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * void INSTRUMENT_begin(int probe)
+ *
+ * @details start a span
+ *
+ * @param probe probe handle, negative handles are ignored
+ */
+HOT_PATH_TEXT void INSTRUMENT_begin(int probe) {
+    if (probe >= 0) {
+        probes[probe].start = INSTRUMENT_now();
+    }
+}
+
+/**
+ * void INSTRUMENT_end(int probe)
+ *
+ * @details end the span started by the last INSTRUMENT_begin and add its
+ *      duration to the statistics, spans up to 2^32 ticks long are
+ *      measured across counter wraps
+ *
+ * @param probe probe handle, negative handles are ignored
+ */
+HOT_PATH_TEXT void INSTRUMENT_end(int probe) {
+    InstrumentProbe *p;
+    u32 duration;
+    int bin;
+
+    if (probe < 0) {
+        return;
+    }
+    p = &probes[probe];
+    duration = INSTRUMENT_now() - p->start;
+
+    p->count++;
+    p->last = duration;
+    p->total += duration;
+    if (duration < p->min) {
+        p->min = duration;
+    }
+    if (duration > p->max) {
+        p->max = duration;
+    }
+
+    bin = duration == 0 ? 0 :
+            31 - __builtin_clz(duration) - INSTRUMENT_HISTOGRAM_MIN_LOG2;
+    if (bin < 0) {
+        bin = 0;
+    } else if (bin >= INSTRUMENT_HISTOGRAM_BINS) {
+        bin = INSTRUMENT_HISTOGRAM_BINS - 1;
+    }
+    p->histogram[bin]++;
+}
+
+/**
+ * const InstrumentProbe *INSTRUMENT_get(int probe)
+ *
+ * @return the statistics of a probe or NULL for an invalid handle
+ */
+const InstrumentProbe *INSTRUMENT_get(int probe) {
+    if (probe < 0 || probe >= probeCount) {
+        return NULL;
+    }
+    return &probes[probe];
+}
+
+/**
+ * void INSTRUMENT_reset(void)
+ *
+ * @details clear the statistics of every probe
+ */
+void INSTRUMENT_reset(void) {
+    int i;
+
+    for (i = 0; i < probeCount; i++) {
+        INSTRUMENT_clear(&probes[i]);
+    }
+}
+
+/**
+ * void INSTRUMENT_report(void)
+ *
+ * @details print the statistics of every probe in microseconds, followed
+ *      by the histogram counts from the shortest bin
+ */
+void INSTRUMENT_report(void) {
+    InstrumentProbe *p;
+    int i;
+    int bin;
+
+    if (INSTRUMENT_CLOCK_HZ == 0) {
+        INSTRUMENT_PRINTF("no timer, span counts only\r\n");
+    }
+    INSTRUMENT_PRINTF("probe count last min mean max (us), 2^%d tick bins\r\n",
+            INSTRUMENT_HISTOGRAM_MIN_LOG2);
+    for (i = 0; i < probeCount; i++) {
+        p = &probes[i];
+        INSTRUMENT_PRINTF("%s %d %d %d %d %d |", p->name, (int) p->count,
+                (int) INSTRUMENT_to_us(p->last),
+                (int) INSTRUMENT_to_us(p->count ? p->min : 0),
+                (int) INSTRUMENT_to_us(p->count ?
+                        (u32) (p->total / p->count) : 0),
+                (int) INSTRUMENT_to_us(p->max));
+        for (bin = 0; bin < INSTRUMENT_HISTOGRAM_BINS; bin++) {
+            INSTRUMENT_PRINTF(" %d", (int) p->histogram[bin]);
+        }
+        INSTRUMENT_PRINTF("\r\n");
+    }
+}
+
+/**
+ * int INSTRUMENT_poll_command(void)
+ *
+ * @details handle a command received on the console UART without
+ *      blocking: 'p' prints the report, 'r' resets the statistics
+ * @return other commands for the caller to handle, -1 if there are none
+ */
+int INSTRUMENT_poll_command(void) {
+#ifdef __MICROBLAZE__
+    u8 command;
+
+    if (XUartLite_IsReceiveEmpty(STDIN_BASEADDRESS)) {
+        return -1;
+    }
+    command = XUartLite_RecvByte(STDIN_BASEADDRESS);
+    if (command == 'p') {
+        INSTRUMENT_report();
+    } else if (command == 'r') {
+        INSTRUMENT_reset();
+    } else {
+        return command;
+    }
+#endif
+    return -1;
+}
+
+/**
+ * static void INSTRUMENT_clear(InstrumentProbe *probe)
+ *
+ * @details clear the statistics of a probe
+ */
+static void INSTRUMENT_clear(InstrumentProbe *probe) {
+    int bin;
+
+    probe->count = 0;
+    probe->last = 0;
+    probe->min = 0xFFFFFFFF;
+    probe->max = 0;
+    probe->total = 0;
+    for (bin = 0; bin < INSTRUMENT_HISTOGRAM_BINS; bin++) {
+        probe->histogram[bin] = 0;
+    }
+}
+
+/**
+ * static u32 INSTRUMENT_to_us(u32 ticks)
+ *
+ * @details convert counter ticks to microseconds
+ */
+static u32 INSTRUMENT_to_us(u32 ticks) {
+#if INSTRUMENT_CLOCK_HZ == 0
+    return 0;
+#else
+    return (u32) (((u64) ticks * 1000000) / INSTRUMENT_CLOCK_HZ);
+#endif
+}
@@ -0,0 +1,73 @@
+/**
+ *
+ * instrument.h: Stage timing probes for the thermal camera pipeline.
+ *
+ * A probe is a named span measured between INSTRUMENT_begin and
+ * INSTRUMENT_end. Every probe keeps its count, last, minimum, maximum and
+ * total duration and a histogram with one bin per power of two.
+ *
+ * The time base is a free-running counter:
+ *  - the first AXI timer when the design has one (XPAR_TMRCTR_0_BASEADDR),
+ *  - clock_gettime(CLOCK_MONOTONIC) in nanoseconds when built on a host.
+ * Without either the spans are only counted and INSTRUMENT_CLOCK_HZ is 0.
+ *
+ * INSTRUMENT_poll_command lets the probes be queried over the UART in
+ * production: 'p' prints the report and 'r' resets the statistics, other
+ * commands are passed back to the caller.
+ *
+ */
+
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+/****************** Include Files ********************/
+#include "xil_types.h"
+#ifdef __MICROBLAZE__
+#include "xparameters.h"
+#endif
+
+#if defined(XPAR_TMRCTR_0_BASEADDR)
+#define INSTRUMENT_CLOCK_HZ XPAR_TMRCTR_0_CLOCK_FREQ_HZ
+#elif !defined(__MICROBLAZE__)
+#define INSTRUMENT_CLOCK_HZ 1000000000
+#else
+#define INSTRUMENT_CLOCK_HZ 0
+#endif
+
+#define INSTRUMENT_MAX_PROBES 16
+
+// histogram bin i counts the durations of 2^(i + MIN_LOG2) to
+// 2^(i + MIN_LOG2 + 1) - 1 ticks, the first and last bins are open
+#define INSTRUMENT_HISTOGRAM_BINS 16
+#define INSTRUMENT_HISTOGRAM_MIN_LOG2 10
+
+typedef struct InstrumentProbe {
+    const char *name;
+    u32 start;          // counter at INSTRUMENT_begin
+    u32 count;          // completed spans
+    u32 last;           // durations in counter ticks
+    u32 min;
+    u32 max;
+    u64 total;
+    u32 histogram[INSTRUMENT_HISTOGRAM_BINS];
+} InstrumentProbe;
+
+void INSTRUMENT_init(void);
+
+int INSTRUMENT_probe(const char *name);
+
+u32 INSTRUMENT_now(void);
+
+void INSTRUMENT_begin(int probe);
+
+void INSTRUMENT_end(int probe);
+
+const InstrumentProbe *INSTRUMENT_get(int probe);
+
+void INSTRUMENT_reset(void);
+
+void INSTRUMENT_report(void);
+
+int INSTRUMENT_poll_command(void);
+
+#endif // INSTRUMENT_H
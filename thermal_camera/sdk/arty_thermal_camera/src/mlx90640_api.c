@@ -1,6 +1,9 @@
 //#include <MLX90640_I2C_Driver.h>
 #include "mlx90640_api.h"
+#include "hot_path.h"
 #include <math.h>
+#include <stdlib.h>
+#include <limits.h>
 
 void ExtractVDDParameters(uint16_t *eeData, paramsMLX90640 *mlx90640);
 void ExtractPTATParameters(uint16_t *eeData, paramsMLX90640 *mlx90640);
@@ -15,7 +18,12 @@ void ExtractKtaPixelParameters(uint16_t *eeData, paramsMLX90640 *mlx90640);
 void ExtractKvPixelParameters(uint16_t *eeData, paramsMLX90640 *mlx90640);
 void ExtractCPParameters(uint16_t *eeData, paramsMLX90640 *mlx90640);
 void ExtractCILCParameters(uint16_t *eeData, paramsMLX90640 *mlx90640);
+uint8_t GetParameterScale(int rawMax, uint8_t rawScale);
+int ScaleParameter(int raw, int shift);
+void CalculateToKernel(uint16_t *frameData, const paramsMLX90640 *params, const uint8_t *emissivityIndex, const float *emissivityReciprocal, int emissivityCount, float tr, float *image, float *result, int16_t *resultCenti);
 int ExtractDeviatingPixels(uint16_t *eeData, paramsMLX90640 *mlx90640);
+void CompilePixelFixes(paramsMLX90640 *mlx90640);
+void CompilePixelFix(uint16_t pixel, int mode, paramsMLX90640 *params, pixelFixMLX90640 *fix);
 int CheckAdjacentPixels(uint16_t pix1, uint16_t pix2);
 float GetMedian(float *values, int n);
 int IsPixelBad(uint16_t pixel,paramsMLX90640 *params);
@@ -158,6 +166,20 @@ int MLX90640_GetFrameData(uint8_t slaveAddr, uint16_t *frameData)
     return frameData[833];
 }
 
+int MLX90640_GetDataReady(uint8_t slaveAddr)
+{
+    uint16_t statusRegister;
+    int error;
+
+    error = MLX90640_I2CRead(slaveAddr, 0x8000, 1, &statusRegister);
+    if(error != 0)
+    {
+        return -1;
+    }
+
+    return (statusRegister & 0x0008) >> 3;
+}
+
 int ValidateFrameData(uint16_t *frameData)
 {
     uint8_t line = 0;
@@ -210,6 +232,10 @@ int ValidateAuxData(uint16_t *auxData)
 
 }
 
+// Works in place on eeData and mlx90640 without pixel sized temporaries:
+// the alpha, kta and kv scales are found in a first integer pass over the
+// EEPROM and the pixel parameters written in a second one. The largest stack
+// frame is the 56 ints of ExtractAlphaParameters and ExtractOffsetParameters.
 int MLX90640_ExtractParameters(uint16_t *eeData, paramsMLX90640 *mlx90640)
 {
     int error = 0;
@@ -369,12 +395,116 @@ int MLX90640_GetCurMode(uint8_t slaveAddr)
 //------------------------------------------------------------------------------
 
 void MLX90640_CalculateTo(uint16_t *frameData, const paramsMLX90640 *params, float emissivity, float tr, float *result)
+{
+    float emissivityReciprocal = 1 / emissivity;
+
+    CalculateToKernel(frameData, params, NULL, &emissivityReciprocal, 1, tr, NULL, result, NULL);
+}
+
+//------------------------------------------------------------------------------
+
+void MLX90640_CalculateToMap(uint16_t *frameData, const paramsMLX90640 *params, const emissivityMapMLX90640 *map, float tr, float *result)
+{
+    CalculateToKernel(frameData, params, map->index, map->reciprocal, map->count, tr, NULL, result, NULL);
+}
+
+//------------------------------------------------------------------------------
+
+void MLX90640_CalculateImageTo(uint16_t *frameData, const paramsMLX90640 *params, const emissivityMapMLX90640 *map, float tr, float *image, float *result)
+{
+    if(result == NULL)
+    {
+        CalculateToKernel(frameData, params, NULL, NULL, 0, tr, image, NULL, NULL);
+    }
+    else
+    {
+        CalculateToKernel(frameData, params, map->index, map->reciprocal, map->count, tr, image, result, NULL);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void MLX90640_CalculateToCenti(uint16_t *frameData, const paramsMLX90640 *params, const emissivityMapMLX90640 *map, float tr, int16_t *result)
+{
+    CalculateToKernel(frameData, params, map->index, map->reciprocal, map->count, tr, NULL, NULL, result);
+}
+
+//------------------------------------------------------------------------------
+
+void MLX90640_CentiToFloat(const int16_t *toCenti, float *result)
+{
+    for(int i = 0; i < 768; i++)
+    {
+        result[i] = toCenti[i] * 0.01f;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+int MLX90640_InitEmissivityMap(emissivityMapMLX90640 *map, float emissivity)
+{
+    if(emissivity <= 0 || emissivity > 1)
+    {
+        return -1;
+    }
+
+    for(int i = 0; i < 768; i++)
+    {
+        map->index[i] = 0;
+    }
+    map->count = 1;
+    map->value[0] = emissivity;
+    map->reciprocal[0] = 1 / emissivity;
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+
+int MLX90640_SetPixelEmissivity(emissivityMapMLX90640 *map, uint16_t pixel, float emissivity)
+{
+    int i;
+
+    if(pixel >= 768 || emissivity <= 0 || emissivity > 1)
+    {
+        return -1;
+    }
+
+    for(i = 0; i < map->count; i++)
+    {
+        if(map->value[i] == emissivity)
+        {
+            break;
+        }
+    }
+
+    if(i == map->count)
+    {
+        if(map->count == MLX90640_MAX_EMISSIVITIES)
+        {
+            return -2;
+        }
+        map->value[i] = emissivity;
+        map->reciprocal[i] = 1 / emissivity;
+        map->count = map->count + 1;
+    }
+    map->index[pixel] = i;
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+
+// Compensated IR image and To, in degrees or centi-degrees, of the pixels of
+// the current subpage. image, result and resultCenti may be NULL.
+// emissivityIndex NULL uses emissivityReciprocal[0].
+HOT_PATH_TEXT void CalculateToKernel(uint16_t *frameData, const paramsMLX90640 *params, const uint8_t *emissivityIndex, const float *emissivityReciprocal, int emissivityCount, float tr, float *image, float *result, int16_t *resultCenti)
 {
     float vdd;
     float ta;
     float ta4;
     float tr4;
-    float taTr;
+    float taTr[MLX90640_MAX_EMISSIVITIES];
     float gain;
     float irDataCP[2];
     float irData;
@@ -394,6 +524,8 @@ void MLX90640_CalculateTo(uint16_t *frameData, const paramsMLX90640 *params, flo
     float alphaScale;
     float kta;
     float kv;
+    uint8_t e;
+    int32_t centi;
 
     subPage = frameData[833];
     vdd = MLX90640_GetVdd(frameData, params);
@@ -405,7 +537,10 @@ void MLX90640_CalculateTo(uint16_t *frameData, const paramsMLX90640 *params, flo
     tr4 = (tr + 273.15);
     tr4 = tr4 * tr4;
     tr4 = tr4 * tr4;
-    taTr = tr4 - (tr4-ta4)/emissivity;
+    for(int i = 0; i < emissivityCount; i++)
+    {
+        taTr[i] = tr4 - (tr4-ta4)*emissivityReciprocal[i];
+    }
 
     ktaScale = pow(2,(double)params->ktaScale);
     kvScale = pow(2,(double)params->kvScale);
@@ -482,15 +617,26 @@ void MLX90640_CalculateTo(uint16_t *frameData, const paramsMLX90640 *params, flo
             }
 
             irData = irData - params->tgc * irDataCP[subPage];
-            irData = irData / emissivity;
+
+            if(image != NULL)
+            {
+                image[pixelNumber] = irData * params->alpha[pixelNumber];
+            }
+            if(result == NULL && resultCenti == NULL)
+            {
+                continue;
+            }
+
+            e = emissivityIndex == NULL ? 0 : emissivityIndex[pixelNumber];
+            irData = irData * emissivityReciprocal[e];
 
             alphaCompensated = SCALEALPHA*alphaScale/params->alpha[pixelNumber];
             alphaCompensated = alphaCompensated*(1 + params->KsTa * (ta - 25));
 
-            Sx = alphaCompensated * alphaCompensated * alphaCompensated * (irData + alphaCompensated * taTr);
+            Sx = alphaCompensated * alphaCompensated * alphaCompensated * (irData + alphaCompensated * taTr[e]);
             Sx = sqrt(sqrt(Sx)) * params->ksTo[1];
 
-            To = sqrt(sqrt(irData/(alphaCompensated * (1 - params->ksTo[1] * 273.15) + Sx) + taTr)) - 273.15;
+            To = sqrt(sqrt(irData/(alphaCompensated * (1 - params->ksTo[1] * 273.15) + Sx) + taTr[e])) - 273.15;
 
             if(To < params->ct[1])
             {
@@ -509,9 +655,25 @@ void MLX90640_CalculateTo(uint16_t *frameData, const paramsMLX90640 *params, flo
                 range = 3;
             }
 
-            To = sqrt(sqrt(irData / (alphaCompensated * alphaCorrR[range] * (1 + params->ksTo[range] * (To - params->ct[range]))) + taTr)) - 273.15;
+            To = sqrt(sqrt(irData / (alphaCompensated * alphaCorrR[range] * (1 + params->ksTo[range] * (To - params->ct[range]))) + taTr[e])) - 273.15;
 
-            result[pixelNumber] = To;
+            if(result != NULL)
+            {
+                result[pixelNumber] = To;
+            }
+            if(resultCenti != NULL)
+            {
+                centi = To * 100 + (To < 0 ? -0.5f : 0.5f);
+                if(centi > 32767)
+                {
+                    centi = 32767;
+                }
+                else if(centi < -32768)
+                {
+                    centi = -32768;
+                }
+                resultCenti[pixelNumber] = centi;
+            }
         }
     }
 }
@@ -520,110 +682,12 @@ void MLX90640_CalculateTo(uint16_t *frameData, const paramsMLX90640 *params, flo
 
 void MLX90640_GetImage(uint16_t *frameData, const paramsMLX90640 *params, float *result)
 {
-    float vdd;
-    float ta;
-    float gain;
-    float irDataCP[2];
-    float irData;
-    float alphaCompensated;
-    uint8_t mode;
-    int8_t ilPattern;
-    int8_t chessPattern;
-    int8_t pattern;
-    int8_t conversionPattern;
-    float image;
-    uint16_t subPage;
-    float ktaScale;
-    float kvScale;
-    float kta;
-    float kv;
-
-    subPage = frameData[833];
-    vdd = MLX90640_GetVdd(frameData, params);
-    ta = MLX90640_GetTa(frameData, params);
-
-    ktaScale = pow(2,(double)params->ktaScale);
-    kvScale = pow(2,(double)params->kvScale);
-
-//------------------------- Gain calculation -----------------------------------
-    gain = frameData[778];
-    if(gain > 32767)
-    {
-        gain = gain - 65536;
-    }
-
-    gain = params->gainEE / gain;
-
-//------------------------- Image calculation -------------------------------------
-    mode = (frameData[832] & 0x1000) >> 5;
-
-    irDataCP[0] = frameData[776];
-    irDataCP[1] = frameData[808];
-    for( int i = 0; i < 2; i++)
-    {
-        if(irDataCP[i] > 32767)
-        {
-            irDataCP[i] = irDataCP[i] - 65536;
-        }
-        irDataCP[i] = irDataCP[i] * gain;
-    }
-    irDataCP[0] = irDataCP[0] - params->cpOffset[0] * (1 + params->cpKta * (ta - 25)) * (1 + params->cpKv * (vdd - 3.3));
-    if( mode ==  params->calibrationModeEE)
-    {
-        irDataCP[1] = irDataCP[1] - params->cpOffset[1] * (1 + params->cpKta * (ta - 25)) * (1 + params->cpKv * (vdd - 3.3));
-    }
-    else
-    {
-      irDataCP[1] = irDataCP[1] - (params->cpOffset[1] + params->ilChessC[0]) * (1 + params->cpKta * (ta - 25)) * (1 + params->cpKv * (vdd - 3.3));
-    }
-
-    for( int pixelNumber = 0; pixelNumber < 768; pixelNumber++)
-    {
-        ilPattern = pixelNumber / 32 - (pixelNumber / 64) * 2;
-        chessPattern = ilPattern ^ (pixelNumber - (pixelNumber/2)*2);
-        conversionPattern = ((pixelNumber + 2) / 4 - (pixelNumber + 3) / 4 + (pixelNumber + 1) / 4 - pixelNumber / 4) * (1 - 2 * ilPattern);
-
-        if(mode == 0)
-        {
-          pattern = ilPattern;
-        }
-        else
-        {
-          pattern = chessPattern;
-        }
-
-        if(pattern == frameData[833])
-        {
-            irData = frameData[pixelNumber];
-            if(irData > 32767)
-            {
-                irData = irData - 65536;
-            }
-            irData = irData * gain;
-
-            kta = params->kta[pixelNumber]/ktaScale;
-            kv = params->kv[pixelNumber]/kvScale;
-            irData = irData - params->offset[pixelNumber]*(1 + kta*(ta - 25))*(1 + kv*(vdd - 3.3));
-
-            if(mode !=  params->calibrationModeEE)
-            {
-              irData = irData + params->ilChessC[2] * (2 * ilPattern - 1) - params->ilChessC[1] * conversionPattern;
-            }
-
-            irData = irData - params->tgc * irDataCP[subPage];
-
-            alphaCompensated = params->alpha[pixelNumber];
-
-            image = irData*alphaCompensated;
-
-            result[pixelNumber] = image;
-        }
-    }
+    CalculateToKernel(frameData, params, NULL, NULL, 0, 0, result, NULL, NULL);
 }
 
 //------------------------------------------------------------------------------
 
-float MLX90640_GetVdd(uint16_t *frameData, const paramsMLX90640 *params)
+HOT_PATH_TEXT float MLX90640_GetVdd(uint16_t *frameData, const paramsMLX90640 *params)
 {
     float vdd;
     float resolutionCorrection;
@@ -644,7 +708,7 @@ float MLX90640_GetVdd(uint16_t *frameData, const paramsMLX90640 *params)
 
 //------------------------------------------------------------------------------
 
-float MLX90640_GetTa(uint16_t *frameData, const paramsMLX90640 *params)
+HOT_PATH_TEXT float MLX90640_GetTa(uint16_t *frameData, const paramsMLX90640 *params)
 {
     float ptat;
     float ptatArt;
@@ -784,6 +848,146 @@ void MLX90640_BadPixelsCorrection(uint16_t *pixels, float *to, int mode, paramsM
 
 //------------------------------------------------------------------------------
 
+void MLX90640_CorrectDeviatingPixels(uint16_t *frameData, const paramsMLX90640 *params, float *to)
+{
+    const pixelFixMLX90640 *fix;
+    const uint16_t *n;
+    float ap[2];
+    float minValue;
+    float maxValue;
+    int mode;
+
+    mode = (frameData[832] & 0x1000) >> 12;
+    fix = params->pixelFix[mode];
+
+    for(int i = 0; i < params->pixelFixCount; i++, fix++)
+    {
+        if(fix->subPage != frameData[833])
+        {
+            continue;
+        }
+
+        n = fix->neighbour;
+        switch(fix->method)
+        {
+            case MLX90640_FIX_COPY:
+                to[fix->pixel] = to[n[0]];
+                break;
+
+            case MLX90640_FIX_MEAN:
+                to[fix->pixel] = (to[n[0]] + to[n[1]])/2.0f;
+                break;
+
+            case MLX90640_FIX_MEDIAN:
+                minValue = to[n[0]];
+                maxValue = to[n[0]];
+                for(int j = 1; j < 4; j++)
+                {
+                    if(to[n[j]] < minValue)
+                    {
+                        minValue = to[n[j]];
+                    }
+                    if(to[n[j]] > maxValue)
+                    {
+                        maxValue = to[n[j]];
+                    }
+                }
+                to[fix->pixel] = (to[n[0]] + to[n[1]] + to[n[2]] + to[n[3]] - minValue - maxValue)/2.0f;
+                break;
+
+            default:
+                ap[0] = to[n[2]] - to[n[3]];
+                ap[1] = to[n[1]] - to[n[0]];
+                if(fabsf(ap[0]) > fabsf(ap[1]))
+                {
+                    to[fix->pixel] = to[n[1]] + ap[1];
+                }
+                else
+                {
+                    to[fix->pixel] = to[n[2]] + ap[0];
+                }
+                break;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+HOT_PATH_TEXT void MLX90640_CorrectDeviatingPixelsCenti(uint16_t *frameData, const paramsMLX90640 *params, int16_t *to)
+{
+    const pixelFixMLX90640 *fix;
+    const uint16_t *n;
+    int32_t ap[2];
+    int32_t minValue;
+    int32_t maxValue;
+    int32_t value;
+    int mode;
+
+    mode = (frameData[832] & 0x1000) >> 12;
+    fix = params->pixelFix[mode];
+
+    for(int i = 0; i < params->pixelFixCount; i++, fix++)
+    {
+        if(fix->subPage != frameData[833])
+        {
+            continue;
+        }
+
+        n = fix->neighbour;
+        switch(fix->method)
+        {
+            case MLX90640_FIX_COPY:
+                value = to[n[0]];
+                break;
+
+            case MLX90640_FIX_MEAN:
+                value = (to[n[0]] + to[n[1]])/2;
+                break;
+
+            case MLX90640_FIX_MEDIAN:
+                minValue = to[n[0]];
+                maxValue = to[n[0]];
+                for(int j = 1; j < 4; j++)
+                {
+                    if(to[n[j]] < minValue)
+                    {
+                        minValue = to[n[j]];
+                    }
+                    if(to[n[j]] > maxValue)
+                    {
+                        maxValue = to[n[j]];
+                    }
+                }
+                value = (to[n[0]] + to[n[1]] + to[n[2]] + to[n[3]] - minValue - maxValue)/2;
+                break;
+
+            default:
+                ap[0] = to[n[2]] - to[n[3]];
+                ap[1] = to[n[1]] - to[n[0]];
+                if(abs(ap[0]) > abs(ap[1]))
+                {
+                    value = to[n[1]] + ap[1];
+                }
+                else
+                {
+                    value = to[n[2]] + ap[0];
+                }
+                if(value > 32767)
+                {
+                    value = 32767;
+                }
+                else if(value < -32768)
+                {
+                    value = -32768;
+                }
+                break;
+        }
+        to[fix->pixel] = value;
+    }
+}
+
+//------------------------------------------------------------------------------
+
 void ExtractVDDParameters(uint16_t *eeData, paramsMLX90640 *mlx90640)
 {
     int16_t kVdd;
@@ -938,11 +1142,15 @@ void ExtractAlphaParameters(uint16_t *eeData, paramsMLX90640 *mlx90640)
     int accColumn[32];
     int p = 0;
     int alphaRef;
+    int alphaRaw;
+    int alphaRawMin;
     uint8_t alphaScale;
     uint8_t accRowScale;
     uint8_t accColumnScale;
     uint8_t accRemScale;
-    float alphaTemp[768];
+    double alphaDivider;
+    double alphaMultiplier;
+    float alphaCP;
     float temp;
 
 
@@ -986,32 +1194,35 @@ void ExtractAlphaParameters(uint16_t *eeData, paramsMLX90640 *mlx90640)
         }
     }
 
+    // The scaled alpha of a pixel is SCALEALPHA over an increasing function
+    // of its raw EEPROM value, so the largest one, which sets alphaScale, is
+    // the one of the smallest raw value. Find it on integers first, then
+    // convert each pixel once straight into mlx90640->alpha.
+    alphaRawMin = INT_MAX;
     for(int i = 0; i < 24; i++)
     {
         for(int j = 0; j < 32; j ++)
         {
             p = 32 * i +j;
-            alphaTemp[p] = (eeData[64 + p] & 0x03F0) >> 4;
-            if (alphaTemp[p] > 31)
+            alphaRaw = (eeData[64 + p] & 0x03F0) >> 4;
+            if (alphaRaw > 31)
+            {
+                alphaRaw = alphaRaw - 64;
+            }
+            alphaRaw = alphaRef + (accRow[i] << accRowScale) + (accColumn[j] << accColumnScale) + alphaRaw * (1 << accRemScale);
+            if (alphaRaw < alphaRawMin)
             {
-                alphaTemp[p] = alphaTemp[p] - 64;
+                alphaRawMin = alphaRaw;
             }
-            alphaTemp[p] = alphaTemp[p]*(1 << accRemScale);
-            alphaTemp[p] = (alphaRef + (accRow[i] << accRowScale) + (accColumn[j] << accColumnScale) + alphaTemp[p]);
-            alphaTemp[p] = alphaTemp[p] / pow(2,(double)alphaScale);
-            alphaTemp[p] = alphaTemp[p] - mlx90640->tgc * (mlx90640->cpAlpha[0] + mlx90640->cpAlpha[1])/2;
-            alphaTemp[p] = SCALEALPHA/alphaTemp[p];
         }
     }
 
-    temp = alphaTemp[0];
-    for(int i = 1; i < 768; i++)
-    {
-        if (alphaTemp[i] > temp)
-        {
-            temp = alphaTemp[i];
-        }
-    }
+    alphaDivider = pow(2,(double)alphaScale);
+    alphaCP = mlx90640->tgc * (mlx90640->cpAlpha[0] + mlx90640->cpAlpha[1])/2;
+
+    temp = alphaRawMin / alphaDivider;
+    temp = temp - alphaCP;
+    temp = SCALEALPHA/temp;
 
     alphaScale = 0;
     while(temp < 32767.4)
@@ -1020,11 +1231,23 @@ void ExtractAlphaParameters(uint16_t *eeData, paramsMLX90640 *mlx90640)
         alphaScale = alphaScale + 1;
     }
 
-    for(int i = 0; i < 768; i++)
+    alphaMultiplier = pow(2,(double)alphaScale);
+    for(int i = 0; i < 24; i++)
     {
-        temp = alphaTemp[i] * pow(2,(double)alphaScale);
-        mlx90640->alpha[i] = (temp + 0.5);
-
+        for(int j = 0; j < 32; j ++)
+        {
+            p = 32 * i +j;
+            alphaRaw = (eeData[64 + p] & 0x03F0) >> 4;
+            if (alphaRaw > 31)
+            {
+                alphaRaw = alphaRaw - 64;
+            }
+            alphaRaw = alphaRef + (accRow[i] << accRowScale) + (accColumn[j] << accColumnScale) + alphaRaw * (1 << accRemScale);
+            temp = alphaRaw / alphaDivider;
+            temp = temp - alphaCP;
+            temp = SCALEALPHA/temp;
+            mlx90640->alpha[p] = (temp * alphaMultiplier + 0.5);
+        }
     }
 
     mlx90640->alphaScale = alphaScale;
@@ -1113,11 +1336,12 @@ void ExtractKtaPixelParameters(uint16_t *eeData, paramsMLX90640 *mlx90640)
     int8_t KtaRoCe;
     int8_t KtaReCo;
     int8_t KtaReCe;
+    uint8_t ktaScale;
     uint8_t ktaScale1;
     uint8_t ktaScale2;
     uint8_t split;
-    float ktaTemp[768];
-    float temp;
+    int ktaRaw;
+    int ktaRawMax;
 
     KtaRoCo = (eeData[54] & 0xFF00) >> 8;
     if (KtaRoCo > 127)
@@ -1150,55 +1374,47 @@ void ExtractKtaPixelParameters(uint16_t *eeData, paramsMLX90640 *mlx90640)
     ktaScale1 = ((eeData[56] & 0x00F0) >> 4) + 8;
     ktaScale2 = (eeData[56] & 0x000F);
 
+    // Kta of a pixel is ktaRaw / 2^ktaScale1, find the scale on the largest
+    // magnitude then store each pixel with integer shifts
+    ktaRawMax = 0;
     for(int i = 0; i < 24; i++)
     {
         for(int j = 0; j < 32; j ++)
         {
             p = 32 * i +j;
-            split = 2*(p/32 - (p/64)*2) + p%2;
-            ktaTemp[p] = (eeData[64 + p] & 0x000E) >> 1;
-            if (ktaTemp[p] > 3)
+            split = 2*(i & 1) + (j & 1);
+            ktaRaw = (eeData[64 + p] & 0x000E) >> 1;
+            if (ktaRaw > 3)
             {
-                ktaTemp[p] = ktaTemp[p] - 8;
+                ktaRaw = ktaRaw - 8;
+            }
+            ktaRaw = KtaRC[split] + ktaRaw * (1 << ktaScale2);
+            if (abs(ktaRaw) > ktaRawMax)
+            {
+                ktaRawMax = abs(ktaRaw);
             }
-            ktaTemp[p] = ktaTemp[p] * (1 << ktaScale2);
-            ktaTemp[p] = KtaRC[split] + ktaTemp[p];
-            ktaTemp[p] = ktaTemp[p] / pow(2,(double)ktaScale1);
-            //ktaTemp[p] = ktaTemp[p] * mlx90640->offset[p];
-        }
-    }
-
-    temp = fabs(ktaTemp[0]);
-    for(int i = 1; i < 768; i++)
-    {
-        if (fabs(ktaTemp[i]) > temp)
-        {
-            temp = fabs(ktaTemp[i]);
         }
     }
 
-    ktaScale1 = 0;
-    while(temp < 63.4)
-    {
-        temp = temp*2;
-        ktaScale1 = ktaScale1 + 1;
-    }
+    ktaScale = GetParameterScale(ktaRawMax, ktaScale1);
 
-    for(int i = 0; i < 768; i++)
+    for(int i = 0; i < 24; i++)
     {
-        temp = ktaTemp[i] * pow(2,(double)ktaScale1);
-        if (temp < 0)
-        {
-            mlx90640->kta[i] = (temp - 0.5);
-        }
-        else
+        for(int j = 0; j < 32; j ++)
         {
-            mlx90640->kta[i] = (temp + 0.5);
+            p = 32 * i +j;
+            split = 2*(i & 1) + (j & 1);
+            ktaRaw = (eeData[64 + p] & 0x000E) >> 1;
+            if (ktaRaw > 3)
+            {
+                ktaRaw = ktaRaw - 8;
+            }
+            ktaRaw = KtaRC[split] + ktaRaw * (1 << ktaScale2);
+            mlx90640->kta[p] = ScaleParameter(ktaRaw, ktaScale - ktaScale1);
         }
-
     }
 
-    mlx90640->ktaScale = ktaScale1;
+    mlx90640->ktaScale = ktaScale;
 }
 
 
@@ -1213,9 +1429,9 @@ void ExtractKvPixelParameters(uint16_t *eeData, paramsMLX90640 *mlx90640)
     int8_t KvReCo;
     int8_t KvReCe;
     uint8_t kvScale;
+    uint8_t kvScaleEE;
     uint8_t split;
-    float kvTemp[768];
-    float temp;
+    int kvRawMax;
 
     KvRoCo = (eeData[52] & 0xF000) >> 12;
     if (KvRoCo > 7)
@@ -1245,52 +1461,72 @@ void ExtractKvPixelParameters(uint16_t *eeData, paramsMLX90640 *mlx90640)
     }
     KvT[3] = KvReCe;
 
-    kvScale = (eeData[56] & 0x0F00) >> 8;
+    kvScaleEE = (eeData[56] & 0x0F00) >> 8;
 
+    // Kv only depends on the row and column parity, every value in the
+    // array is one of the four KvT / 2^kvScaleEE
+    kvRawMax = 0;
+    for(int i = 0; i < 4; i++)
+    {
+        if (abs(KvT[i]) > kvRawMax)
+        {
+            kvRawMax = abs(KvT[i]);
+        }
+    }
+
+    kvScale = GetParameterScale(kvRawMax, kvScaleEE);
+
+    for(int i = 0; i < 4; i++)
+    {
+        KvT[i] = ScaleParameter(KvT[i], kvScale - kvScaleEE);
+    }
 
     for(int i = 0; i < 24; i++)
     {
         for(int j = 0; j < 32; j ++)
         {
             p = 32 * i +j;
-            split = 2*(p/32 - (p/64)*2) + p%2;
-            kvTemp[p] = KvT[split];
-            kvTemp[p] = kvTemp[p] / pow(2,(double)kvScale);
-            //kvTemp[p] = kvTemp[p] * mlx90640->offset[p];
+            split = 2*(i & 1) + (j & 1);
+            mlx90640->kv[p] = KvT[split];
         }
     }
 
-    temp = fabs(kvTemp[0]);
-    for(int i = 1; i < 768; i++)
+    mlx90640->kvScale = kvScale;
+}
+
+//------------------------------------------------------------------------------
+
+uint8_t GetParameterScale(int rawMax, uint8_t rawScale)
+{
+    uint8_t scale = 0;
+
+    // smallest scale for which rawMax * 2^scale / 2^rawScale >= 63.4
+    if (rawMax == 0)
     {
-        if (fabs(kvTemp[i]) > temp)
-        {
-            temp = fabs(kvTemp[i]);
-        }
+        return 0;
     }
-
-    kvScale = 0;
-    while(temp < 63.4)
+    while((((uint64_t)rawMax << scale) * 5) < ((uint64_t)317 << rawScale))
     {
-        temp = temp*2;
-        kvScale = kvScale + 1;
+        scale = scale + 1;
     }
 
-    for(int i = 0; i < 768; i++)
-    {
-        temp = kvTemp[i] * pow(2,(double)kvScale);
-        if (temp < 0)
-        {
-            mlx90640->kv[i] = (temp - 0.5);
-        }
-        else
-        {
-            mlx90640->kv[i] = (temp + 0.5);
-        }
+    return scale;
+}
+
+//------------------------------------------------------------------------------
 
+int ScaleParameter(int raw, int shift)
+{
+    int value;
+
+    // raw * 2^shift rounded half away from zero
+    if (shift >= 0)
+    {
+        return raw * (1 << shift);
     }
+    value = (abs(raw) + (1 << (-shift - 1))) >> -shift;
 
-    mlx90640->kvScale = kvScale;
+    return raw < 0 ? -value : value;
 }
 
 //------------------------------------------------------------------------------
@@ -1427,6 +1663,8 @@ int ExtractDeviatingPixels(uint16_t *eeData, paramsMLX90640 *mlx90640)
 
     }
 
+    CompilePixelFixes(mlx90640);
+
     if(brokenPixCnt > 4)
     {
         warn = -3;
@@ -1484,6 +1722,120 @@ int ExtractDeviatingPixels(uint16_t *eeData, paramsMLX90640 *mlx90640)
 
 }
 
+//------------------------------------------------------------------------------
+
+void CompilePixelFixes(paramsMLX90640 *mlx90640)
+{
+    uint16_t pixels[MLX90640_MAX_DEVIATING_PIXELS];
+    uint8_t count = 0;
+
+    for(int i = 0; i < 5; i++)
+    {
+        if(mlx90640->brokenPixels[i] != 0xFFFF)
+        {
+            pixels[count++] = mlx90640->brokenPixels[i];
+        }
+        if(mlx90640->outlierPixels[i] != 0xFFFF)
+        {
+            pixels[count++] = mlx90640->outlierPixels[i];
+        }
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        CompilePixelFix(pixels[i], 0, mlx90640, &mlx90640->pixelFix[0][i]);
+        CompilePixelFix(pixels[i], 1, mlx90640, &mlx90640->pixelFix[1][i]);
+    }
+
+    mlx90640->pixelFixCount = count;
+}
+
+//------------------------------------------------------------------------------
+
+void CompilePixelFix(uint16_t pixel, int mode, paramsMLX90640 *params, pixelFixMLX90640 *fix)
+{
+    uint8_t line;
+    uint8_t column;
+    uint16_t *n;
+
+    line = pixel>>5;
+    column = pixel - (line<<5);
+    n = fix->neighbour;
+
+    fix->pixel = pixel;
+    fix->method = MLX90640_FIX_MEAN;
+
+    if(mode == 1)
+    {
+        fix->subPage = (line & 1) ^ (column & 1);
+
+        if(line == 0 || line == 23)
+        {
+            if(column == 0 || column == 31)
+            {
+                fix->method = MLX90640_FIX_COPY;
+                n[0] = (line == 0) ? (column == 0 ? 33 : 62) : (column == 0 ? 705 : 734);
+            }
+            else if(line == 0)
+            {
+                n[0] = pixel+31;
+                n[1] = pixel+33;
+            }
+            else
+            {
+                n[0] = pixel-33;
+                n[1] = pixel-31;
+            }
+        }
+        else if(column == 0)
+        {
+            n[0] = pixel-31;
+            n[1] = pixel+33;
+        }
+        else if(column == 31)
+        {
+            n[0] = pixel-33;
+            n[1] = pixel+31;
+        }
+        else
+        {
+            fix->method = MLX90640_FIX_MEDIAN;
+            n[0] = pixel-33;
+            n[1] = pixel-31;
+            n[2] = pixel+31;
+            n[3] = pixel+33;
+        }
+    }
+    else
+    {
+        fix->subPage = line & 1;
+
+        if(column == 0)
+        {
+            fix->method = MLX90640_FIX_COPY;
+            n[0] = pixel+1;
+        }
+        else if(column == 31)
+        {
+            fix->method = MLX90640_FIX_COPY;
+            n[0] = pixel-1;
+        }
+        else if(column == 1 || column == 30 || IsPixelBad(pixel-2,params) != 0 || IsPixelBad(pixel+2,params) != 0)
+        {
+            n[0] = pixel-1;
+            n[1] = pixel+1;
+        }
+        else
+        {
+            fix->method = MLX90640_FIX_GRADIENT;
+            n[0] = pixel-2;
+            n[1] = pixel-1;
+            n[2] = pixel+1;
+            n[3] = pixel+2;
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
 
  int CheckAdjacentPixels(uint16_t pix1, uint16_t pix2)
@@ -1,6 +1,30 @@
+#ifndef _MLX90640_API_H_
+#define _MLX90640_API_H_
+
 #include <stdio.h>
 #define SCALEALPHA 0.000001
 
+#define MLX90640_LINE_NUM 24
+#define MLX90640_COLUMN_NUM 32
+#define MLX90640_PIXEL_NUM 768
+
+#define MLX90640_MAX_DEVIATING_PIXELS 10
+
+#define MLX90640_FIX_COPY 0
+#define MLX90640_FIX_MEAN 1
+#define MLX90640_FIX_MEDIAN 2
+#define MLX90640_FIX_GRADIENT 3
+
+#define MLX90640_MAX_EMISSIVITIES 16
+
+typedef struct
+    {
+        uint16_t pixel;
+        uint16_t neighbour[4];
+        uint8_t method;
+        uint8_t subPage;
+    } pixelFixMLX90640;
+
 typedef struct
     {
         int16_t kVdd;
@@ -30,17 +54,34 @@ typedef struct
         float ilChessC[3];
         uint16_t brokenPixels[5];
         uint16_t outlierPixels[5];
+        pixelFixMLX90640 pixelFix[2][MLX90640_MAX_DEVIATING_PIXELS]; //[mode][]
+        uint8_t pixelFixCount;
     } paramsMLX90640;
 
+typedef struct
+    {
+        uint8_t index[768]; //value of each pixel
+        uint8_t count;
+        float value[MLX90640_MAX_EMISSIVITIES];
+        float reciprocal[MLX90640_MAX_EMISSIVITIES];
+    } emissivityMapMLX90640;
+
     int MLX90640_DumpEE(uint8_t slaveAddr, uint16_t *eeData);
     int MLX90640_SynchFrame(uint8_t slaveAddr);
     int MLX90640_TriggerMeasurement(uint8_t slaveAddr);
     int MLX90640_GetFrameData(uint8_t slaveAddr, uint16_t *frameData);
+    int MLX90640_GetDataReady(uint8_t slaveAddr);
     int MLX90640_ExtractParameters(uint16_t *eeData, paramsMLX90640 *mlx90640);
     float MLX90640_GetVdd(uint16_t *frameData, const paramsMLX90640 *params);
     float MLX90640_GetTa(uint16_t *frameData, const paramsMLX90640 *params);
     void MLX90640_GetImage(uint16_t *frameData, const paramsMLX90640 *params, float *result);
     void MLX90640_CalculateTo(uint16_t *frameData, const paramsMLX90640 *params, float emissivity, float tr, float *result);
+    void MLX90640_CalculateToMap(uint16_t *frameData, const paramsMLX90640 *params, const emissivityMapMLX90640 *map, float tr, float *result);
+    void MLX90640_CalculateImageTo(uint16_t *frameData, const paramsMLX90640 *params, const emissivityMapMLX90640 *map, float tr, float *image, float *result);
+    void MLX90640_CalculateToCenti(uint16_t *frameData, const paramsMLX90640 *params, const emissivityMapMLX90640 *map, float tr, int16_t *result);
+    void MLX90640_CentiToFloat(const int16_t *toCenti, float *result);
+    int MLX90640_InitEmissivityMap(emissivityMapMLX90640 *map, float emissivity);
+    int MLX90640_SetPixelEmissivity(emissivityMapMLX90640 *map, uint16_t pixel, float emissivity);
     int MLX90640_SetResolution(uint8_t slaveAddr, uint8_t resolution);
     int MLX90640_GetCurResolution(uint8_t slaveAddr);
     int MLX90640_SetRefreshRate(uint8_t slaveAddr, uint8_t refreshRate);
@@ -50,3 +91,7 @@ typedef struct
     int MLX90640_SetInterleavedMode(uint8_t slaveAddr);
     int MLX90640_SetChessMode(uint8_t slaveAddr);
     void MLX90640_BadPixelsCorrection(uint16_t *pixels, float *to, int mode, paramsMLX90640 *params);
+    void MLX90640_CorrectDeviatingPixels(uint16_t *frameData, const paramsMLX90640 *params, float *to);
+    void MLX90640_CorrectDeviatingPixelsCenti(uint16_t *frameData, const paramsMLX90640 *params, int16_t *to);
+
+#endif
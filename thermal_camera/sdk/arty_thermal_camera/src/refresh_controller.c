@@ -0,0 +1,172 @@
+/**
+ *
+ * refresh_controller.c: Adaptive refresh rate controller for the MLX90640.
+ *
+ */
+
+/***************************** Include Files *******************************/
+#include "refresh_controller.h"
+
+/************************** Local Functions Prototypes ***********************/
+
+static int REFRESH_CONTROLLER_set_rate(RefreshController* controller,
+        u8 rate);
+
+/************************** Function Definitions ***************************/
+
+/**
+ * int REFRESH_CONTROLLER_init(RefreshController* controller, u8 slaveAddr,
+ *      u8 minRate, u8 maxRate, u32 options)
+ *
+ * @details initialize the controller starting from the rate currently
+ *      programmed in the sensor, clamped to minRate..maxRate
+ *
+ * @param controller    controller state
+ * @param slaveAddr     sensor I2C address
+ * @param minRate       lowest refresh rate code allowed
+ * @param maxRate       highest refresh rate code allowed
+ * @param options       current processing options
+ * @return 0 on success or a negative MLX90640 I2C error
+ */
+int REFRESH_CONTROLLER_init(RefreshController* controller, u8 slaveAddr,
+        u8 minRate, u8 maxRate, u32 options) {
+    int rate;
+
+    controller->slaveAddr = slaveAddr;
+    controller->minRate = minRate;
+    controller->maxRate = maxRate > REFRESH_RATE_64HZ ?
+            REFRESH_RATE_64HZ : maxRate;
+    controller->options = options;
+    controller->lastSubPage = -1;
+    REFRESH_CONTROLLER_retune(controller);
+
+    rate = MLX90640_GetRefreshRate(slaveAddr);
+    if (rate < 0) {
+        return rate;
+    }
+    if (rate < controller->minRate) {
+        rate = controller->minRate;
+    } else if (rate > controller->maxRate) {
+        rate = controller->maxRate;
+    }
+    controller->rate = 0xFF;
+    rate = REFRESH_CONTROLLER_set_rate(controller, rate);
+    return rate < 0 ? rate : 0;
+}
+
+/**
+ * void REFRESH_CONTROLLER_retune(RefreshController* controller)
+ *
+ * @details forget the failed probes so that the controller looks for
+ *      the best rate again from the current one
+ *
+ * @param controller    controller state
+ */
+void REFRESH_CONTROLLER_retune(RefreshController* controller) {
+    controller->lateCount = 0;
+    controller->recovery = 0;
+    controller->slackCount = 0;
+    controller->holdoff = REFRESH_CONTROLLER_MIN_HOLDOFF;
+}
+
+/**
+ * int REFRESH_CONTROLLER_update(RefreshController* controller, int subPage,
+ *      u32 idlePolls, u32 options)
+ *
+ * @details evaluate the last subpage and change the sensor refresh rate
+ *      when needed
+ *
+ * @param controller    controller state
+ * @param subPage       subpage number returned by MLX90640_GetFrameData
+ * @param idlePolls     times the data ready flag was found clear before
+ *                      the subpage was available
+ * @param options       current processing options, any change retunes
+ * @return 1 if the refresh rate was changed, 0 if not, or a negative
+ *      MLX90640 I2C error
+ */
+int REFRESH_CONTROLLER_update(RefreshController* controller, int subPage,
+        u32 idlePolls, u32 options) {
+    int dropped;
+
+    if (options != controller->options) {
+        controller->options = options;
+        REFRESH_CONTROLLER_retune(controller);
+    }
+
+    dropped = subPage == controller->lastSubPage;
+    controller->lastSubPage = subPage;
+
+    if (controller->settle > 0) {
+        controller->settle--;
+        return 0;
+    }
+
+    if (idlePolls > 0) {
+        controller->recovery = 0;
+    } else if (controller->recovery > 0) {
+        controller->recovery--;
+        if (!dropped) {
+            return 0;
+        }
+    }
+
+    if (dropped || idlePolls == 0) {
+        controller->slackCount = 0;
+        controller->lateCount++;
+        if (dropped || controller->lateCount >= REFRESH_CONTROLLER_LATE_LIMIT) {
+            controller->lateCount = 0;
+            if (controller->holdoff < REFRESH_CONTROLLER_MAX_HOLDOFF) {
+                controller->holdoff <<= 1;
+            }
+            if (controller->rate > controller->minRate) {
+                controller->recovery = REFRESH_CONTROLLER_RECOVERY;
+                return REFRESH_CONTROLLER_set_rate(controller,
+                        controller->rate - 1);
+            }
+        }
+        return 0;
+    }
+
+    controller->lateCount = 0;
+    controller->slackCount++;
+    if (controller->slackCount >= controller->holdoff
+            && controller->rate < controller->maxRate) {
+        controller->slackCount = 0;
+        return REFRESH_CONTROLLER_set_rate(controller, controller->rate + 1);
+    }
+    return 0;
+}
+
+/**
+ * u8 REFRESH_CONTROLLER_get_rate(RefreshController* controller)
+ *
+ * @return the refresh rate code currently programmed in the sensor
+ */
+u8 REFRESH_CONTROLLER_get_rate(RefreshController* controller) {
+    return controller->rate;
+}
+
+/**
+ * static int REFRESH_CONTROLLER_set_rate(RefreshController* controller,
+ *      u8 rate)
+ *
+ * @details program a new refresh rate, the next subpages are skipped
+ *      while the sensor switches
+ */
+static int REFRESH_CONTROLLER_set_rate(RefreshController* controller,
+        u8 rate) {
+    int error;
+
+    if (rate == controller->rate) {
+        return 0;
+    }
+    error = MLX90640_SetRefreshRate(controller->slaveAddr, rate);
+    if (error != 0) {
+        return error < 0 ? error : -1;
+    }
+    controller->rate = rate;
+    controller->settle = REFRESH_CONTROLLER_SETTLE;
+    controller->slackCount = 0;
+    controller->lateCount = 0;
+    return 1;
+}
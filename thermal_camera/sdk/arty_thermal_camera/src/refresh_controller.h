@@ -0,0 +1,72 @@
+/**
+ *
+ * refresh_controller.h: Adaptive refresh rate controller for the MLX90640.
+ *
+ * Chooses the highest sensor refresh rate the processing pipeline can
+ * sustain without dropping subpages. The pipeline load is measured every
+ * subpage by the sensor itself:
+ *  - idle polls, the number of times the data ready flag was found clear
+ *    before the subpage was available. Zero means the subpage was already
+ *    waiting, so the pipeline took longer than the sensor period.
+ *  - dropped subpages, the same subpage number read twice in a row.
+ *
+ * The controller steps the rate down when the pipeline falls behind and
+ * periodically probes the next higher rate when there is slack. Failed
+ * probes double the time before the next one. A change in the processing
+ * options passed to REFRESH_CONTROLLER_update restarts the tuning.
+ *
+ */
+
+#ifndef REFRESH_CONTROLLER_H
+#define REFRESH_CONTROLLER_H
+
+/****************** Include Files ********************/
+#include "xil_types.h"
+#include "mlx90640_api.h"
+
+// MLX90640 refresh rate codes, subpages per second
+#define REFRESH_RATE_0_5HZ  0
+#define REFRESH_RATE_1HZ    1
+#define REFRESH_RATE_2HZ    2
+#define REFRESH_RATE_4HZ    3
+#define REFRESH_RATE_8HZ    4
+#define REFRESH_RATE_16HZ   5
+#define REFRESH_RATE_32HZ   6
+#define REFRESH_RATE_64HZ   7
+
+// consecutive subpages without idle polls that mean the pipeline is late
+#define REFRESH_CONTROLLER_LATE_LIMIT       3
+// subpages after a rate change that are not evaluated
+#define REFRESH_CONTROLLER_SETTLE           2
+// subpages after a step down during which only drops count as late,
+// the backlog of the overrun is drained before the first idle poll
+#define REFRESH_CONTROLLER_RECOVERY         16
+// subpages with slack before probing a higher rate, doubled on failure
+#define REFRESH_CONTROLLER_MIN_HOLDOFF      16
+#define REFRESH_CONTROLLER_MAX_HOLDOFF      1024
+
+typedef struct RefreshController {
+    u8 slaveAddr;       // sensor I2C address
+    u8 rate;            // current refresh rate code
+    u8 minRate;         // rate codes allowed
+    u8 maxRate;
+    u8 settle;          // subpages to skip after a rate change
+    u8 lateCount;       // consecutive subpages without idle polls
+    u8 recovery;        // subpages left to drain the backlog of a step down
+    u16 slackCount;     // consecutive subpages with idle polls
+    u16 holdoff;        // slack subpages needed before the next probe
+    s16 lastSubPage;    // subpage number of the previous update
+    u32 options;        // processing options the rate was tuned for
+} RefreshController;
+
+int REFRESH_CONTROLLER_init(RefreshController* controller, u8 slaveAddr,
+        u8 minRate, u8 maxRate, u32 options);
+
+void REFRESH_CONTROLLER_retune(RefreshController* controller);
+
+int REFRESH_CONTROLLER_update(RefreshController* controller, int subPage,
+        u32 idlePolls, u32 options);
+
+u8 REFRESH_CONTROLLER_get_rate(RefreshController* controller);
+
+#endif // REFRESH_CONTROLLER_H
@@ -0,0 +1,237 @@
+/**
+ *
+ * roi_engine.c: Region of interest measurements on the MLX90640 array.
+ *
+ * Each subpage keeps its own accumulators, so the statistics of a region
+ * always combine the latest values of both subpages. The per pixel cost
+ * depends on the number of regions the pixel belongs to, pixels outside
+ * every region only cost a mask test.
+ *
+ */
+
+/***************************** Include Files *******************************/
+#include "roi_engine.h"
+#include "hot_path.h"
+
+/************************** Local Functions Prototypes ***********************/
+
+static void ROI_ENGINE_combine(RoiEngine* engine, int region);
+static u32 ROI_ENGINE_isqrt(u32 value);
+
+/************************** Function Definitions ***************************/
+
+/**
+ * void ROI_ENGINE_init(RoiEngine* engine)
+ *
+ * @details initialize the engine without regions
+ *
+ * @param engine    engine state
+ */
+void ROI_ENGINE_init(RoiEngine* engine) {
+    int i;
+
+    for (i = 0; i < MLX90640_PIXEL_NUM; i++) {
+        engine->mask[i] = 0;
+    }
+    engine->regionCount = 0;
+}
+
+/**
+ * int ROI_ENGINE_add_rectangle(RoiEngine* engine, u8 left, u8 top,
+ *      u8 right, u8 bottom)
+ *
+ * @details add a rectangular region, corners are inclusive
+ *
+ * @param engine    engine state
+ * @param left      first column 0 to 31
+ * @param top       first line 0 to 23
+ * @param right     last column 0 to 31
+ * @param bottom    last line 0 to 23
+ * @return the region index in engine->stats or -1 if no region is left
+ *      or the rectangle is outside the array
+ */
+int ROI_ENGINE_add_rectangle(RoiEngine* engine, u8 left, u8 top, u8 right,
+        u8 bottom) {
+    u32 bit;
+    int line;
+    int column;
+
+    if (engine->regionCount == ROI_MAX_REGIONS || left > right || top > bottom
+            || right >= MLX90640_COLUMN_NUM || bottom >= MLX90640_LINE_NUM) {
+        return -1;
+    }
+
+    bit = 1UL << engine->regionCount;
+    for (line = top; line <= bottom; line++) {
+        for (column = left; column <= right; column++) {
+            engine->mask[line * MLX90640_COLUMN_NUM + column] |= bit;
+        }
+    }
+    return engine->regionCount++;
+}
+
+/**
+ * int ROI_ENGINE_add_mask(RoiEngine* engine, const u8 *pixelMask)
+ *
+ * @details add a region of arbitrary shape
+ *
+ * @param engine    engine state
+ * @param pixelMask MLX90640_PIXEL_NUM bytes, non zero for the pixels
+ *                  of the region
+ * @return the region index in engine->stats or -1 if no region is left
+ */
+int ROI_ENGINE_add_mask(RoiEngine* engine, const u8 *pixelMask) {
+    u32 bit;
+    int i;
+
+    if (engine->regionCount == ROI_MAX_REGIONS) {
+        return -1;
+    }
+
+    bit = 1UL << engine->regionCount;
+    for (i = 0; i < MLX90640_PIXEL_NUM; i++) {
+        if (pixelMask[i]) {
+            engine->mask[i] |= bit;
+        }
+    }
+    return engine->regionCount++;
+}
+
+/**
+ * void ROI_ENGINE_update(RoiEngine* engine, uint16_t *frameData,
+ *      const int16_t *to)
+ *
+ * @details accumulate the pixels of the subpage contained in frameData
+ *      and update the statistics of every region
+ *
+ * @param engine    engine state
+ * @param frameData frame data used to calculate to
+ * @param to        object temperatures in centi-degrees from
+ *                  MLX90640_CalculateToCenti
+ */
+HOT_PATH_TEXT void ROI_ENGINE_update(RoiEngine* engine, uint16_t *frameData,
+        const int16_t *to) {
+    int chessMode = (frameData[832] & 0x1000) != 0;
+    int subPage = frameData[833] & 0x0001;
+    RoiAccumulator *acc = engine->subPage[subPage];
+    RoiAccumulator *a;
+    int line;
+    int column;
+    int step;
+    int p;
+    int region;
+    u32 members;
+    s32 x;
+
+    for (region = 0; region < engine->regionCount; region++) {
+        acc[region].count = 0;
+        acc[region].min = 32767;
+        acc[region].max = -32768;
+        acc[region].sum = 0;
+        acc[region].sumSquares = 0;
+    }
+
+    step = chessMode ? 2 : 1;
+
+    for (line = 0; line < MLX90640_LINE_NUM; line++) {
+        if (chessMode) {
+            column = (line & 1) ^ subPage;
+        } else if ((line & 1) == subPage) {
+            column = 0;
+        } else {
+            continue;
+        }
+
+        for (; column < MLX90640_COLUMN_NUM; column += step) {
+            p = line * MLX90640_COLUMN_NUM + column;
+            members = engine->mask[p];
+            if (members == 0) {
+                continue;
+            }
+
+            x = to[p];
+
+            while (members != 0) {
+                a = &acc[__builtin_ctz(members)];
+                members &= members - 1;
+
+                a->count++;
+                a->sum += x;
+                a->sumSquares += (u32) (x * x);
+                if (x < a->min) {
+                    a->min = x;
+                }
+                if (x > a->max) {
+                    a->max = x;
+                }
+            }
+        }
+    }
+
+    for (region = 0; region < engine->regionCount; region++) {
+        ROI_ENGINE_combine(engine, region);
+    }
+}
+
+/**
+ * static void ROI_ENGINE_combine(RoiEngine* engine, int region)
+ *
+ * @details combine the accumulators of both subpages into the region stats
+ */
+static void ROI_ENGINE_combine(RoiEngine* engine, int region) {
+    RoiAccumulator *a0 = &engine->subPage[0][region];
+    RoiAccumulator *a1 = &engine->subPage[1][region];
+    RoiStats *stats = &engine->stats[region];
+    s64 sum;
+    u64 sumSquares;
+    u64 variance;
+    u32 n;
+
+    n = a0->count + a1->count;
+    stats->count = n;
+    if (n == 0) {
+        stats->min = 0;
+        stats->max = 0;
+        stats->mean = 0;
+        stats->stddev = 0;
+        return;
+    }
+
+    sum = (s64) a0->sum + a1->sum;
+    sumSquares = a0->sumSquares + a1->sumSquares;
+
+    stats->min = a1->count == 0 || (a0->count != 0 && a0->min < a1->min) ?
+            a0->min : a1->min;
+    stats->max = a1->count == 0 || (a0->count != 0 && a0->max > a1->max) ?
+            a0->max : a1->max;
+    stats->mean = (sum >= 0 ? sum + n / 2 : sum - (s32) (n / 2)) / (s32) n;
+
+    // n * sum(x^2) - sum(x)^2 is never negative
+    variance = (n * sumSquares - (u64) (sum * sum)) / ((u64) n * n);
+    stats->stddev = ROI_ENGINE_isqrt(
+            variance > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : (u32) variance);
+}
+
+/**
+ * static u32 ROI_ENGINE_isqrt(u32 value)
+ *
+ * @details integer square root, rounded down
+ */
+static u32 ROI_ENGINE_isqrt(u32 value) {
+    u32 root = 0;
+    u32 bit = 1UL << 30;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
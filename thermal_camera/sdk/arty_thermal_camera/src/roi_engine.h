@@ -0,0 +1,59 @@
+/**
+ *
+ * roi_engine.h: Region of interest measurements on the MLX90640 array.
+ *
+ * Up to ROI_MAX_REGIONS rectangular or masked regions are compiled into
+ * one membership bit mask per pixel. Every update makes a single pass over
+ * the pixels of the subpage just calculated and updates the minimum,
+ * maximum, mean and standard deviation of all the regions at once.
+ * Temperatures are in centi-degrees.
+ *
+ * Call ROI_ENGINE_init, add the regions, then call ROI_ENGINE_update after
+ * each MLX90640_CalculateToCenti with the same frame data.
+ *
+ */
+
+#ifndef ROI_ENGINE_H
+#define ROI_ENGINE_H
+
+/****************** Include Files ********************/
+#include "xil_types.h"
+#include "mlx90640_api.h"
+
+// one bit per region in the pixel membership masks
+#define ROI_MAX_REGIONS 32
+
+typedef struct RoiStats {
+    u16 count;   // pixels in the region
+    s16 min;     // centi-degrees
+    s16 max;     // centi-degrees
+    s16 mean;    // centi-degrees
+    u16 stddev;  // centi-degrees
+} RoiStats;
+
+typedef struct RoiAccumulator {
+    u16 count;
+    s16 min;
+    s16 max;
+    s32 sum;
+    u64 sumSquares;
+} RoiAccumulator;
+
+typedef struct RoiEngine {
+    u32 mask[MLX90640_PIXEL_NUM];  // regions each pixel belongs to
+    u8 regionCount;
+    RoiAccumulator subPage[2][ROI_MAX_REGIONS];
+    RoiStats stats[ROI_MAX_REGIONS]; // both subpages combined
+} RoiEngine;
+
+void ROI_ENGINE_init(RoiEngine* engine);
+
+int ROI_ENGINE_add_rectangle(RoiEngine* engine, u8 left, u8 top, u8 right,
+        u8 bottom);
+
+int ROI_ENGINE_add_mask(RoiEngine* engine, const u8 *pixelMask);
+
+void ROI_ENGINE_update(RoiEngine* engine, uint16_t *frameData,
+        const int16_t *to);
+
+#endif // ROI_ENGINE_H
@@ -0,0 +1,109 @@
+/**
+ *
+ * sensor_bus.c: Several MLX90640 sensors sharing one AXI IIC bus.
+ *
+ */
+
+/***************************** Include Files *******************************/
+#include "sensor_bus.h"
+
+/************************** Function Definitions ***************************/
+
+/**
+ * void SENSOR_BUS_init(SensorBus* bus)
+ *
+ * @details initialize the bus without sensors
+ *
+ * @param bus   bus state
+ */
+void SENSOR_BUS_init(SensorBus* bus) {
+    bus->sensorCount = 0;
+    bus->next = 0;
+}
+
+/**
+ * int SENSOR_BUS_add(SensorBus* bus, ThermalSensor* sensor, u8 slaveAddr,
+ *      uint16_t *eeData)
+ *
+ * @details read the calibration of a sensor and add it to the schedule.
+ *      Deviating pixel warnings of MLX90640_ExtractParameters do not prevent
+ *      adding the sensor, those pixels are corrected, the warning is kept in
+ *      sensor->paramsWarning
+ *
+ * @param bus       bus state
+ * @param sensor    sensor state, owned by the bus from now on
+ * @param slaveAddr sensor I2C address
+ * @param eeData    832 words to dump the EEPROM into, only used during
+ *                  the call and can be shared by all the sensors
+ * @return the sensor index in bus->sensors, -1 if the bus is full or
+ *      the negative I2C error of the EEPROM dump
+ */
+int SENSOR_BUS_add(SensorBus* bus, ThermalSensor* sensor, u8 slaveAddr,
+        uint16_t *eeData) {
+    int error;
+
+    if (bus->sensorCount == SENSOR_BUS_MAX_SENSORS) {
+        return -1;
+    }
+
+    sensor->slaveAddr = slaveAddr;
+    sensor->subPage = -1;
+    sensor->idlePolls = 0;
+    sensor->subPageCount = 0;
+
+    error = MLX90640_DumpEE(slaveAddr, eeData);
+    if (error != 0) {
+        return error < 0 ? error : -1;
+    }
+    sensor->paramsWarning = MLX90640_ExtractParameters(eeData,
+            &sensor->params);
+
+    bus->sensors[bus->sensorCount] = sensor;
+    return bus->sensorCount++;
+}
+
+/**
+ * int SENSOR_BUS_read_next(SensorBus* bus)
+ *
+ * @details wait for the next sensor with a new subpage and read it into
+ *      its frameData
+ *
+ * @param bus   bus state
+ * @return the index of the sensor read or a negative MLX90640 error
+ */
+int SENSOR_BUS_read_next(SensorBus* bus) {
+    ThermalSensor *sensor;
+    int index;
+    int ready;
+    int subPage;
+
+    if (bus->sensorCount == 0) {
+        return -1;
+    }
+
+    index = bus->next;
+    while (1) {
+        sensor = bus->sensors[index];
+        ready = MLX90640_GetDataReady(sensor->slaveAddr);
+        if (ready < 0) {
+            return ready;
+        }
+        if (ready) {
+            break;
+        }
+        sensor->idlePolls++;
+        if (++index == bus->sensorCount) {
+            index = 0;
+        }
+    }
+
+    bus->next = index + 1 == bus->sensorCount ? 0 : index + 1;
+
+    subPage = MLX90640_GetFrameData(sensor->slaveAddr, sensor->frameData);
+    if (subPage < 0) {
+        return subPage;
+    }
+    sensor->subPage = subPage;
+    sensor->subPageCount++;
+    return index;
+}
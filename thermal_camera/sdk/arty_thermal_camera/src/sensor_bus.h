@@ -0,0 +1,53 @@
+/**
+ *
+ * sensor_bus.h: Several MLX90640 sensors sharing one AXI IIC bus.
+ *
+ * Every sensor has its own I2C address, calibration, frame buffers and
+ * subpage state. The addresses are programmed beforehand in the sensor
+ * EEPROM (I2C address register 0x240F), they all leave the factory at 0x33.
+ *
+ * The sensors run from their own clocks, so the bus scheduler polls their
+ * data ready flags round robin and reads whichever subpage is waiting. The
+ * bus never blocks on a sensor that is still integrating while another one
+ * has data, and after a read the next sensor in turn is polled first, so
+ * a ready sensor waits for at most one subpage read of every other sensor.
+ *
+ * Call SENSOR_BUS_init, SENSOR_BUS_add for each sensor, then
+ * SENSOR_BUS_read_next in the main loop.
+ *
+ */
+
+#ifndef SENSOR_BUS_H
+#define SENSOR_BUS_H
+
+/****************** Include Files ********************/
+#include "xil_types.h"
+#include "mlx90640_api.h"
+
+#define SENSOR_BUS_MAX_SENSORS 4
+
+typedef struct ThermalSensor {
+    u8 slaveAddr;       // sensor I2C address
+    s8 subPage;         // subpage in frameData, -1 before the first read
+    u32 idlePolls;      // data ready polls that found no new subpage
+    u32 subPageCount;   // subpages read since SENSOR_BUS_add
+    int paramsWarning;  // MLX90640_ExtractParameters deviating pixel warning, 0 if none
+    uint16_t frameData[834];
+    paramsMLX90640 params;
+    int16_t to[MLX90640_PIXEL_NUM]; // object temperatures in centi-degrees
+} ThermalSensor;
+
+typedef struct SensorBus {
+    u8 sensorCount;
+    u8 next;            // sensor polled first by SENSOR_BUS_read_next
+    ThermalSensor *sensors[SENSOR_BUS_MAX_SENSORS];
+} SensorBus;
+
+void SENSOR_BUS_init(SensorBus* bus);
+
+int SENSOR_BUS_add(SensorBus* bus, ThermalSensor* sensor, u8 slaveAddr,
+        uint16_t *eeData);
+
+int SENSOR_BUS_read_next(SensorBus* bus);
+
+#endif // SENSOR_BUS_H
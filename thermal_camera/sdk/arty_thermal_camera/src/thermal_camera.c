@@ -3,12 +3,22 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "xil_types.h"
 #include "xil_cache.h"
 #include "xil_printf.h"
 #include "xparameters.h"
 #include "zybo_vga/display_ctrl.h"
 #include "mlx90640_api.h"
+#include "thermal_filter.h"
+#include "hotspot_detector.h"
+#include "roi_engine.h"
+#include "refresh_controller.h"
+#include "sensor_bus.h"
+#include "instrument.h"
+#include "frame_allocator.h"
+#include "hot_path.h"
 #include "platform.h"
 
 #include "xiic.h"
@@ -25,14 +35,23 @@
 #define INTC_DEVICE_ID		XPAR_INTC_0_DEVICE_ID
 #define IIC_INTR_ID	XPAR_INTC_0_IIC_0_VEC_ID
 
-// Frame size (based on 1440x900 resolution, 32 bits per pixel)
-#define MAX_FRAME (800*600)
-#define FRAME_STRIDE (800*4)
+// Largest video mode the frame buffer sets are sized for (32 bits per pixel),
+// every mode in videoModes must fit
+#define FRAME_MAX_WIDTH 800
+#define FRAME_MAX_HEIGHT 600
 
+// Video modes cycled through with 'm' on the console. The spare set of frame
+// buffers is cleared for the new mode a few lines per loop, then the display
+// switches to it in a vertical blank while the sensors keep being read
+const VideoMode *const videoModes[] = { &VMODE_800x600, &VMODE_640x480 };
+#define VIDEO_MODE_COUNT (sizeof(videoModes) / sizeof(videoModes[0]))
+#define FRAME_SETS 2
+#define FRAME_CLEAR_LINES 60
 
 DisplayCtrl dispCtrl; // Display driver struct
-u32 frameBuf[DISPLAY_NUM_FRAMES][MAX_FRAME]; // Frame buffers for video data
-void *pFrames[DISPLAY_NUM_FRAMES]; // Array of pointers to the frame buffers
+u8 framePool[FRAME_SETS][FRAME_ALLOCATOR_REGION_SIZE(FRAME_MAX_WIDTH,
+		FRAME_MAX_HEIGHT)]; // DDR for the frame buffer sets
+FrameAllocator frameSets[FRAME_SETS]; // Frame buffers laid out for a video mode
 
 XIic IicInstance; /* The instance of the IIC device */
 
@@ -41,6 +60,18 @@ XIntc InterruptController; /* The instance of the Interrupt controller */
 #define IIC_SLAVE_ADDR		0x33
 #define IIC_SCLK_RATE		100000
 
+// Sensors on the IIC bus, stitched left to right on the display. Each extra
+// sensor needs its own address programmed in its EEPROM, e.g. { 0x33, 0x34 }
+const u8 sensorAddresses[] = { IIC_SLAVE_ADDR };
+#define SENSOR_COUNT (sizeof(sensorAddresses) / sizeof(sensorAddresses[0]))
+
+SensorBus sensorBus;
+ThermalSensor sensors[SENSOR_COUNT] HOT_PATH_DATA;
+
+// Emissivity of the scene seen by each sensor, set per pixel with
+// MLX90640_SetPixelEmissivity when it mixes materials
+emissivityMapMLX90640 emissivityMaps[SENSOR_COUNT] HOT_PATH_DATA;
+
 volatile u8 TransmitComplete;
 volatile u8 ReceiveComplete;
 
@@ -50,6 +81,43 @@ volatile u8 ReceiveComplete;
 #define TEST_BUFFER_SIZE	512
 #define TA_SHIFT 8
 
+// Temporal noise filter: Q8 smoothing factor for static pixels and the
+// change in centi-degrees above which a pixel is not smoothed
+#define FILTER_ALPHA_MIN 64
+#define FILTER_MOTION_THRESHOLD 200
+
+// Toggled with 'f' on the console
+u8 temporalFilterEnabled = 1;
+ThermalFilter thermalFilters[SENSOR_COUNT] HOT_PATH_DATA;
+
+// Hot spot detection: threshold in centi-degrees and minimum area in pixels
+#define HOTSPOT_THRESHOLD 3000
+#define HOTSPOT_MIN_AREA 2
+
+HotSpotDetector hotSpotDetector;
+
+// Region of interest measurements, region 0 is the whole array
+#define ROI_FULL_FRAME 0
+
+RoiEngine roiEngines[SENSOR_COUNT] HOT_PATH_DATA;
+
+// Adaptive sensor refresh rate, retuned whenever the pipeline options change
+#define REFRESH_RATE_MIN REFRESH_RATE_1HZ
+#define REFRESH_RATE_MAX REFRESH_RATE_32HZ
+
+#define PIPELINE_OPTION_FILTER (1 << 0)
+
+RefreshController refreshControllers[SENSOR_COUNT];
+
+// Pipeline stage timings, sent over the UART on request
+int probeRead;
+int probeTo;
+int probeFilter;
+int probeRoi;
+int probeHotSpot;
+int probeRender;
+int probeSync;
+
 /************************** Function Prototypes ******************************/
 
 int IicRepeatedStartExample();
@@ -67,13 +135,14 @@ int MLX90640_I2CWrite(uint8_t slaveAddr, uint16_t writeAddress, uint16_t data);
 void VGA_Fill_Display(float *mlx90640Frame);
 void VGA_DrawPixel(uint16_t x, uint16_t y, uint16_t color);
 long map(long x, long in_min, long in_max, long out_min, long out_max);
+u32 pipelineOptions(void);
 
 u8 SendBuffer[TEST_BUFFER_SIZE];    //I2C TX
 u8 RecvBuffer[TEST_BUFFER_SIZE];    //I2C RX
 
 u16 frame[WIDTH][HEIGHT];
 
-const u32 camColors[] = { 0x480F, 0x400F, 0x400F, 0x400F, 0x4010, 0x3810,
+const u32 camColors[] HOT_PATH_RODATA = { 0x480F, 0x400F, 0x400F, 0x400F, 0x4010, 0x3810,
 		0x3810, 0x3810, 0x3810, 0x3010, 0x3010, 0x3010, 0x2810, 0x2810, 0x2810,
 		0x2810, 0x2010, 0x2010, 0x2010, 0x1810, 0x1810, 0x1811, 0x1811, 0x1011,
 		0x1011, 0x1011, 0x0811, 0x0811, 0x0811, 0x0011, 0x0011, 0x0011, 0x0011,
@@ -171,112 +240,295 @@ int main(void) {
 
 	// print("XIic_Start\n\r");
 
-	static u16 mlx90640Frame[834];
 	static uint16_t eeMLX90640[832];
-	paramsMLX90640 mlx90640;
 
 	float Ta;
 	float emissivity = 0.95;
-	static float mlx90640To[768];
 
-	MLX90640_DumpEE(0x33, eeMLX90640);
-	// print("MLX90640_DumpEE\n\r");
-	MLX90640_ExtractParameters(eeMLX90640, &mlx90640);
-	// print("MLX90640_ExtractParameters\n\r");
+	int s;
+	int error;
+	SENSOR_BUS_init(&sensorBus);
+	for (s = 0; s < SENSOR_COUNT; s++) {
+		error = SENSOR_BUS_add(&sensorBus, &sensors[s], sensorAddresses[s],
+				eeMLX90640);
+		if (error < 0) {
+			xil_printf("MLX90640 at 0x%02x EEPROM not read, error %d\r\n",
+					sensorAddresses[s], error);
+			return XST_FAILURE;
+		}
+		if (sensors[s].paramsWarning != 0) {
+			xil_printf("MLX90640 at 0x%02x deviating pixels warning %d\r\n",
+					sensorAddresses[s], sensors[s].paramsWarning);
+		}
+		// print("MLX90640_ExtractParameters\n\r");
+		MLX90640_InitEmissivityMap(&emissivityMaps[s], emissivity);
+		THERMAL_FILTER_init(&thermalFilters[s], FILTER_ALPHA_MIN,
+				FILTER_MOTION_THRESHOLD);
+		ROI_ENGINE_init(&roiEngines[s]);
+		ROI_ENGINE_add_rectangle(&roiEngines[s], 0, 0, WIDTH - 1, HEIGHT - 1);
+		if (REFRESH_CONTROLLER_init(&refreshControllers[s], sensorAddresses[s],
+				REFRESH_RATE_MIN, REFRESH_RATE_MAX, pipelineOptions()) < 0) {
+			xil_printf("MLX90640 at 0x%02x refresh rate not set\r\n",
+					sensorAddresses[s]);
+			return XST_FAILURE;
+		}
+	}
+	HOTSPOT_DETECTOR_init(&hotSpotDetector, HOTSPOT_THRESHOLD,
+			HOTSPOT_MIN_AREA, HOTSPOT_CONNECTIVITY_8);
 
 	xil_printf("Successfully started vga example\r\n");
-
-	// Initialise an array of pointers to the 2 frame buffers
+	HOT_PATH_PRINT_USAGE();
+
+	INSTRUMENT_init();
+	probeRead = INSTRUMENT_probe("read");
+	probeTo = INSTRUMENT_probe("to");
+	probeFilter = INSTRUMENT_probe("filter");
+	probeRoi = INSTRUMENT_probe("roi");
+	probeHotSpot = INSTRUMENT_probe("hotspot");
+	probeRender = INSTRUMENT_probe("render");
+	probeSync = INSTRUMENT_probe("sync");
+	xil_printf("Send p for stage timings, r to reset them, m to change the video mode\r\n");
+
+	// Give the frame buffers of the 2 sets of 2 their own DDR banks
 	int i;
-	for (i = 0; i < DISPLAY_NUM_FRAMES; i++)
-		pFrames[i] = frameBuf[i];
+	u32 set;
+	for (set = 0; set < FRAME_SETS; set++)
+		FRAME_ALLOCATOR_init(&frameSets[set], framePool[set],
+				sizeof(framePool[set]), set * DISPLAY_NUM_FRAMES);
+
+	int modeIndex = 0; // videoModes entry shown
+	int nextModeIndex = -1; // videoModes entry the spare set is prepared for
+	u32 frameSet = 0; // frame buffer set shown
+	u32 clearLine = 0; // lines of the spare set cleared so far
+	u32 clearCount;
+	int command;
+	FrameAllocator *spare;
+
+	if (FRAME_ALLOCATOR_alloc(&frameSets[frameSet], videoModes[modeIndex]) < 0) {
+		xil_printf("%s does not fit the frame buffers\r\n",
+				videoModes[modeIndex]->label);
+		return XST_FAILURE;
+	}
 
 	// Initialise the display controller
 	DisplayInitialize(&dispCtrl, XPAR_AXIVDMA_0_DEVICE_ID, XPAR_VTC_0_DEVICE_ID,
-	XPAR_VGA_AXI_DYNCLK_0_BASEADDR, pFrames, FRAME_STRIDE);
+	XPAR_VGA_AXI_DYNCLK_0_BASEADDR, frameSets[frameSet].frames,
+			frameSets[frameSet].stride);
 
 	// Start with the first frame buffer (of two)
 	DisplayChangeFrame(&dispCtrl, 0);
 
 	// Set the display resolution
-	DisplaySetMode(&dispCtrl, &VMODE_800x600);
+	DisplaySetMode(&dispCtrl, videoModes[modeIndex]);
 
 	// Enable video output
 	DisplayStart(&dispCtrl);
 
-	// Get parameters from display controller struct
 	int x, y;
-	u32 stride = dispCtrl.stride / 4;
-	u32 width = dispCtrl.vMode.width;
-	u32 height = dispCtrl.vMode.height;
+	u32 stride;
+	u32 width;
+	u32 height;
+	const VideoMode *mode;
+	u8 switching;
 
 	u32 *frame;
 
 	u32 buff = dispCtrl.curFrame;
 
+	ThermalSensor *sensor;
+
 	while (1) {
 
-		MLX90640_GetFrameData(0x33, mlx90640Frame);
+		spare = &frameSets[!frameSet];
+		command = INSTRUMENT_poll_command();
+		if (command == 'm' && nextModeIndex < 0) {
+			nextModeIndex = (modeIndex + 1) % VIDEO_MODE_COUNT;
+			clearLine = 0;
+			if (FRAME_ALLOCATOR_alloc(spare, videoModes[nextModeIndex]) < 0) {
+				xil_printf("%s does not fit the frame buffers\r\n",
+						videoModes[nextModeIndex]->label);
+				nextModeIndex = -1;
+			}
+		} else if (command == 'f') {
+			// The filters restart from the next frame, the refresh
+			// controllers retune on their next update with the new options
+			temporalFilterEnabled = !temporalFilterEnabled;
+			for (s = 0; s < SENSOR_COUNT; s++) {
+				THERMAL_FILTER_reset(&thermalFilters[s]);
+			}
+			xil_printf("Temporal filter %s\r\n",
+					temporalFilterEnabled ? "on" : "off");
+		}
+
+		// Black out the spare frame buffers for the next mode, the sensors
+		// are served between the slices
+		if (nextModeIndex >= 0 && clearLine
+				< DISPLAY_NUM_FRAMES * videoModes[nextModeIndex]->height) {
+			height = videoModes[nextModeIndex]->height;
+			y = clearLine % height;
+			clearCount = height - y;
+			if (clearCount > FRAME_CLEAR_LINES) {
+				clearCount = FRAME_CLEAR_LINES;
+			}
+			memset((u8 *) spare->frames[clearLine / height] + y * spare->stride,
+					0, clearCount * spare->stride);
+			clearLine += clearCount;
+		}
+
+		// Read the next sensor with a subpage waiting, the polls that found
+		// it not ready measure the pipeline slack for its refresh controller
+		INSTRUMENT_begin(probeRead);
+		s = SENSOR_BUS_read_next(&sensorBus);
+		INSTRUMENT_end(probeRead);
 		// print("MLX90640_GetFrameData\n\r");
-		Ta = MLX90640_GetTa(mlx90640Frame, &mlx90640) - TA_SHIFT;
+		if (s < 0) {
+			continue;
+		}
+		sensor = &sensors[s];
+		REFRESH_CONTROLLER_update(&refreshControllers[s], sensor->subPage,
+				sensor->idlePolls, pipelineOptions());
+		sensor->idlePolls = 0;
+
+		INSTRUMENT_begin(probeTo);
+		Ta = MLX90640_GetTa(sensor->frameData, &sensor->params) - TA_SHIFT;
 		// print("MLX90640_GetTa\n\r");
-		MLX90640_CalculateTo(mlx90640Frame, &mlx90640, emissivity, Ta,
-				mlx90640To);
-
-		float maxTemp = 0.0;
-		float minTemp = 9999.99;
-		for (int i = 0; i < 768; ++i) {
-			if (mlx90640To[i] < minTemp) {
-				minTemp = mlx90640To[i];
+		MLX90640_CalculateToCenti(sensor->frameData, &sensor->params,
+				&emissivityMaps[s], Ta, sensor->to);
+		MLX90640_CorrectDeviatingPixelsCenti(sensor->frameData,
+				&sensor->params, sensor->to);
+		INSTRUMENT_end(probeTo);
+		if (temporalFilterEnabled) {
+			INSTRUMENT_begin(probeFilter);
+			THERMAL_FILTER_update(&thermalFilters[s], sensor->frameData,
+					sensor->to);
+			INSTRUMENT_end(probeFilter);
+		}
+
+		INSTRUMENT_begin(probeRoi);
+		ROI_ENGINE_update(&roiEngines[s], sensor->frameData, sensor->to);
+		INSTRUMENT_end(probeRoi);
+
+		// Common colour range so that the stitched images match
+		s16 maxCenti = roiEngines[0].stats[ROI_FULL_FRAME].max;
+		s16 minCenti = roiEngines[0].stats[ROI_FULL_FRAME].min;
+		for (i = 1; i < SENSOR_COUNT; i++) {
+			if (roiEngines[i].stats[ROI_FULL_FRAME].count == 0) {
+				continue;
+			}
+			if (roiEngines[i].stats[ROI_FULL_FRAME].max > maxCenti) {
+				maxCenti = roiEngines[i].stats[ROI_FULL_FRAME].max;
 			}
-			if (mlx90640To[i] > maxTemp) {
-				maxTemp = mlx90640To[i];
+			if (roiEngines[i].stats[ROI_FULL_FRAME].min < minCenti) {
+				minCenti = roiEngines[i].stats[ROI_FULL_FRAME].min;
 			}
 		}
-		xil_printf("MAX Temp: %d.%d, MIN Temp %d.%d\n\r",(int)maxTemp, ((int)(maxTemp*100))%100,(int)minTemp, ((int)(minTemp*100))%100);
+		xil_printf("MAX Temp: %s%d.%02d, MIN Temp %s%d.%02d\n\r",
+				maxCenti < 0 ? "-" : "", abs(maxCenti) / 100, abs(maxCenti) % 100,
+				minCenti < 0 ? "-" : "", abs(minCenti) / 100, abs(minCenti) % 100);
+
+		INSTRUMENT_begin(probeHotSpot);
+		HOTSPOT_DETECTOR_detect(&hotSpotDetector, sensor->to);
+		INSTRUMENT_end(probeHotSpot);
+		for (int i = 0; i < hotSpotDetector.spotCount; ++i) {
+			HotSpot *spot = &hotSpotDetector.spots[i];
+			xil_printf("HOT %d.%d: area %d centroid %d,%d peak %d box %d,%d-%d,%d\n\r",
+					s, i, spot->area, spot->centroidX, spot->centroidY,
+					spot->peak, spot->left, spot->top, spot->right,
+					spot->bottom);
+		}
 
 		// Switch the frame we're modifying to be back buffer (1 to 0, or 0 to 1)
+		INSTRUMENT_begin(probeRender);
 		buff = !buff;
 		frame = dispCtrl.framePtr[buff];
+		stride = dispCtrl.stride / 4;
+		mode = &dispCtrl.vMode;
+
+		// Once the spare set is ready the image goes to it instead, in the
+		// frame index being shown so the display carries on from there
+		switching = nextModeIndex >= 0
+				&& clearLine >= DISPLAY_NUM_FRAMES * videoModes[nextModeIndex]->height;
+		if (switching) {
+			buff = dispCtrl.curFrame;
+			frame = spare->frames[buff];
+			stride = spare->stride / 4;
+			mode = videoModes[nextModeIndex];
+		}
+		width = mode->width;
+		height = mode->height;
 
 		// Clear the frame to white
-		// memset(frame, 0xFF, MAX_FRAME * 4);
+		// memset(frame, 0xFF, height * stride * 4);
 
-		float temp;
+		s16 temp;
 		u8 mapped;
 		u32 colour;
-		int scale = 24;
-		int frameWidth = WIDTH * scale;
+		u32 lineColours[WIDTH * SENSOR_COUNT];
+		u32 *line;
+		// Largest whole scale that fits the mode, letterboxed in the middle
+		int scale = width / (WIDTH * SENSOR_COUNT);
+		if (height / HEIGHT < scale) {
+			scale = height / HEIGHT;
+		}
+		int frameWidth = WIDTH * scale * SENSOR_COUNT;
 		int frameHeight = HEIGHT * scale;
 
 		int yo = (height - frameHeight) / 2 ;
 		int xo = (width - frameWidth) /2;
 
-		for (y = 0; y < frameHeight; y++)
-			for (x = 0; x < frameWidth; x++) {
+		if (maxCenti <= minCenti) {
+			maxCenti = minCenti + 1;
+		}
 
-				temp = (mlx90640To[x / scale + y / scale * 32]);
-				mapped = map((u16) temp, minTemp, maxTemp, 0, 255);
+		for (y = 0; y < HEIGHT; y++) {
+
+			// Map a line of sensor pixels once, it is drawn scale times
+			for (x = 0; x < WIDTH * SENSOR_COUNT; x++) {
+				temp = sensors[x / WIDTH].to[x % WIDTH + y * WIDTH];
+				if (temp < minCenti) {
+					temp = minCenti;
+				} else if (temp > maxCenti) {
+					temp = maxCenti;
+				}
+				mapped = map(temp, minCenti, maxCenti, 0, 255);
 				colour = (((camColors[mapped] >> 12) & 0x0F)
 						<< (BIT_DISPLAY_RED + 4))
 						| (((camColors[mapped] >> 7) & 0x0F)
 								<< (BIT_DISPLAY_GREEN + 4))
 						| ((camColors[mapped] >> 1) & 0x0F)
 								<< (BIT_DISPLAY_BLUE + 4);
+				lineColours[x] = colour;
+			}
 
-				frame[(y+yo) * stride + x + xo] = colour;
-
+			for (i = 0; i < scale; i++) {
+				line = &frame[(y * scale + i + yo) * stride + xo];
+				for (x = 0; x < WIDTH * SENSOR_COUNT; x++) {
+					for (int j = 0; j < scale; j++) {
+						*line++ = lineColours[x];
+					}
+				}
 			}
+		}
 
 		// Flush everything out to DDR
 		Xil_DCacheFlush()
 		;
 
-		// Switch active frame to the back buffer
-		DisplayChangeFrame(&dispCtrl, buff);
+		if (switching) {
+			DisplaySwitchMode(&dispCtrl, mode, spare->frames, spare->stride);
+			frameSet = !frameSet;
+			modeIndex = nextModeIndex;
+			nextModeIndex = -1;
+		} else {
+			// Switch active frame to the back buffer
+			DisplayChangeFrame(&dispCtrl, buff);
+		}
+		INSTRUMENT_end(probeRender);
 
 		// Wait for the frame to switch (after active frame is drawn) before continuing
+		INSTRUMENT_begin(probeSync);
 		DisplayWaitForSync(&dispCtrl);
+		INSTRUMENT_end(probeSync);
 	}
 
 	/*
@@ -296,6 +548,19 @@ long map(long x, long in_min, long in_max, long out_min, long out_max) {
 	return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
 }
 
+/*
+ * Processing options enabled in the pipeline, a change retunes the
+ * sensor refresh rate
+ */
+u32 pipelineOptions(void) {
+	u32 options = 0;
+
+	if (temporalFilterEnabled) {
+		options |= PIPELINE_OPTION_FILTER;
+	}
+	return options;
+}
+
 
 int MLX90640_I2CRead(uint8_t slaveAddr, uint16_t startAddress,
 		uint16_t nMemAddressRead, uint16_t *data) {
@@ -309,6 +574,14 @@ int MLX90640_I2CRead(uint8_t slaveAddr, uint16_t startAddress,
 	 */
 	ReceiveComplete = 1;
 
+	/*
+	 * Address the sensor, several of them can share the bus.
+	 */
+	Status = XIic_SetAddress(&IicInstance, XII_ADDR_TO_SEND_TYPE, slaveAddr);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
 	/*
 	 * Set the Repeated Start option.
 	 */
@@ -317,7 +590,9 @@ int MLX90640_I2CRead(uint8_t slaveAddr, uint16_t startAddress,
 	int cnt = 0;
 	int i = 0;
 	u8 cmd[2] = { 0, 0 };
-	u8 i2cData[1664] = { 0 };
+	// a full frame read, static to keep it off the 4 KB stack. The bus is
+	// only used from the main loop, so the buffer is never shared
+	static u8 i2cData[1664];
 	uint16_t *p;
 
 	p = data;
@@ -372,6 +647,14 @@ int MLX90640_I2CWrite(uint8_t slaveAddr, uint16_t writeAddress, uint16_t data) {
 	 */
 	TransmitComplete = 1;
 
+	/*
+	 * Address the sensor, several of them can share the bus.
+	 */
+	Status = XIic_SetAddress(&IicInstance, XII_ADDR_TO_SEND_TYPE, slaveAddr);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
 	/*
 	 * Set the Repeated Start option.
 	 */
@@ -0,0 +1,118 @@
+/**
+ *
+ * thermal_filter.c: Per-pixel temporal noise filter for the MLX90640
+ * object temperatures.
+ *
+ * y += (x - y) * alpha, with alpha in Q8 growing linearly from alphaMin
+ * at no change up to 1.0 at motionThreshold centi-degrees of change.
+ * The update costs a handful of integer operations per pixel.
+ *
+ */
+
+/***************************** Include Files *******************************/
+#include "thermal_filter.h"
+#include "hot_path.h"
+
+/************************** Function Definitions ***************************/
+
+/**
+ * void THERMAL_FILTER_init(ThermalFilter* filter, u16 alphaMin,
+ *      u16 motionThreshold)
+ *
+ * @details initialize the filter, the first frame of each subpage
+ *      passes through unfiltered
+ *
+ * @param filter            filter state
+ * @param alphaMin          Q8 smoothing factor for static pixels, 1 to 256
+ * @param motionThreshold   change in centi-degrees that is followed
+ *                          without smoothing
+ */
+void THERMAL_FILTER_init(ThermalFilter* filter, u16 alphaMin,
+        u16 motionThreshold) {
+    if (alphaMin > THERMAL_FILTER_ALPHA_ONE) {
+        alphaMin = THERMAL_FILTER_ALPHA_ONE;
+    }
+    if (motionThreshold == 0) {
+        motionThreshold = 1;
+    }
+    filter->alphaMin = alphaMin;
+    filter->motionThreshold = motionThreshold;
+    filter->motionSlope = ((u32) (THERMAL_FILTER_ALPHA_ONE - alphaMin) << 8)
+            / motionThreshold;
+    THERMAL_FILTER_reset(filter);
+}
+
+/**
+ * void THERMAL_FILTER_reset(ThermalFilter* filter)
+ *
+ * @details forget the filter history, for example after a change
+ *      of refresh rate or of the scene
+ *
+ * @param filter    filter state
+ */
+void THERMAL_FILTER_reset(ThermalFilter* filter) {
+    filter->primed[0] = 0;
+    filter->primed[1] = 0;
+}
+
+/**
+ * void THERMAL_FILTER_update(ThermalFilter* filter, uint16_t *frameData,
+ *      int16_t *to)
+ *
+ * @details filter in place the pixels of the subpage contained in frameData
+ *
+ * @param filter    filter state
+ * @param frameData frame data used to calculate to
+ * @param to        object temperatures in centi-degrees from
+ *                  MLX90640_CalculateToCenti
+ */
+HOT_PATH_TEXT void THERMAL_FILTER_update(ThermalFilter* filter, uint16_t *frameData,
+        int16_t *to) {
+    int16_t *state = filter->state;
+    int chessMode = (frameData[832] & 0x1000) != 0;
+    int subPage = frameData[833] & 0x0001;
+    int primed = filter->primed[subPage];
+    int line;
+    int column;
+    int step;
+    int p;
+    s32 x;
+    s32 d;
+    u32 absD;
+    u32 alpha;
+
+    step = chessMode ? 2 : 1;
+
+    for (line = 0; line < MLX90640_LINE_NUM; line++) {
+        if (chessMode) {
+            column = (line & 1) ^ subPage;
+        } else if ((line & 1) == subPage) {
+            column = 0;
+        } else {
+            continue;
+        }
+
+        for (; column < MLX90640_COLUMN_NUM; column += step) {
+            p = line * MLX90640_COLUMN_NUM + column;
+
+            x = to[p];
+
+            if (primed) {
+                d = x - state[p];
+                absD = d < 0 ? -d : d;
+                if (absD >= filter->motionThreshold) {
+                    alpha = THERMAL_FILTER_ALPHA_ONE;
+                } else {
+                    alpha = filter->alphaMin
+                            + ((absD * filter->motionSlope) >> 8);
+                }
+                x = state[p] + ((d * (s32) alpha + 128) >> 8);
+            }
+
+            state[p] = (int16_t) x;
+            to[p] = (int16_t) x;
+        }
+    }
+
+    filter->primed[subPage] = 1;
+}
@@ -0,0 +1,43 @@
+/**
+ *
+ * thermal_filter.h: Per-pixel temporal noise filter for the MLX90640
+ * object temperatures.
+ *
+ * Exponential smoothing in fixed point with a motion-adaptive coefficient:
+ * pixels whose temperature barely changes are smoothed with alphaMin,
+ * pixels that change by motionThreshold or more follow the input directly.
+ * The filtered temperature of every pixel is kept in centi-degrees in an
+ * int16 array.
+ *
+ * Call THERMAL_FILTER_update right after MLX90640_CalculateToCenti with
+ * the same frame data. Only the pixels of the subpage in the frame are updated.
+ *
+ */
+
+#ifndef THERMAL_FILTER_H
+#define THERMAL_FILTER_H
+
+/****************** Include Files ********************/
+#include "xil_types.h"
+#include "mlx90640_api.h"
+
+// alpha is a Q8 value, 256 means no filtering
+#define THERMAL_FILTER_ALPHA_ONE 256
+
+typedef struct ThermalFilter {
+    int16_t state[MLX90640_PIXEL_NUM]; // filtered To in centi-degrees
+    u16 alphaMin;        // Q8 smoothing factor for static pixels
+    u16 motionThreshold; // change in centi-degrees that disables smoothing
+    u32 motionSlope;     // Q8 alpha increment per centi-degree of change
+    u8 primed[2];        // subpage already holds a valid state
+} ThermalFilter;
+
+void THERMAL_FILTER_init(ThermalFilter* filter, u16 alphaMin,
+        u16 motionThreshold);
+
+void THERMAL_FILTER_reset(ThermalFilter* filter);
+
+void THERMAL_FILTER_update(ThermalFilter* filter, uint16_t *frameData,
+        int16_t *to);
+
+#endif // THERMAL_FILTER_H
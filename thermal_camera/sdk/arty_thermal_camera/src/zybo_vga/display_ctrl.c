@@ -33,7 +33,9 @@
 /*         Repeat as needed, only ever modifying inactive frames.       */
 /*      5) To change the resolution, call DisplaySetMode, followed by   */
 /*         DisplayStart again.                                          */
-/*                                                                      */
+/*      6) To change the resolution without stopping the display, draw  */
+/*         the first image of the new mode into a new set of            */
+/*         framebuffers and call DisplaySwitchMode.                     */
 /*                                                                      */
 /************************************************************************/
 /*  Revision History:                                                   */
@@ -73,6 +75,37 @@
 /*				Procedure Definitions							*/
 /* ------------------------------------------------------------ */
 
+/***	DisplayVtcTiming(const VideoMode *mode, XVtc_Timing *vtcTiming)
+**
+**	Parameters:
+**		mode - The VideoMode struct to convert
+**		vtcTiming - Pointer to the VTC timing struct that is filled in
+**
+**	Return Value: none
+**
+**	Description:
+**		Converts a video mode to the generator timing of the vtc core.
+**
+*/
+static void DisplayVtcTiming(const VideoMode *mode, XVtc_Timing *vtcTiming)
+{
+	vtcTiming->HActiveVideo = mode->width;	/**< Horizontal Active Video Size */
+	vtcTiming->HFrontPorch = mode->hps - mode->width;	/**< Horizontal Front Porch Size */
+	vtcTiming->HSyncWidth = mode->hpe - mode->hps;		/**< Horizontal Sync Width */
+	vtcTiming->HBackPorch = mode->hmax - mode->hpe + 1;		/**< Horizontal Back Porch Size */
+	vtcTiming->HSyncPolarity = mode->hpol;	/**< Horizontal Sync Polarity */
+	vtcTiming->VActiveVideo = mode->height;	/**< Vertical Active Video Size */
+	vtcTiming->V0FrontPorch = mode->vps - mode->height;	/**< Vertical Front Porch Size */
+	vtcTiming->V0SyncWidth = mode->vpe - mode->vps;	/**< Vertical Sync Width */
+	vtcTiming->V0BackPorch = mode->vmax - mode->vpe + 1;;	/**< Horizontal Back Porch Size */
+	vtcTiming->V1FrontPorch = mode->vps - mode->height;	/**< Vertical Front Porch Size */
+	vtcTiming->V1SyncWidth = mode->vpe - mode->vps;	/**< Vertical Sync Width */
+	vtcTiming->V1BackPorch = mode->vmax - mode->vpe + 1;;	/**< Horizontal Back Porch Size */
+	vtcTiming->VSyncPolarity = mode->vpol;	/**< Vertical Sync Polarity */
+	vtcTiming->Interlaced = 0;		/**< Interlaced / Progressive video */
+}
+/* ------------------------------------------------------------ */
+
 /***	DisplayStop(DisplayCtrl *dispPtr)
 **
 **	Parameters:
@@ -194,20 +227,7 @@ int DisplayStart(DisplayCtrl *dispPtr)
 	/*
 	 * Configure the vtc core with the display mode timing parameters
 	 */
-	vtcTiming.HActiveVideo = dispPtr->vMode.width;	/**< Horizontal Active Video Size */
-	vtcTiming.HFrontPorch = dispPtr->vMode.hps - dispPtr->vMode.width;	/**< Horizontal Front Porch Size */
-	vtcTiming.HSyncWidth = dispPtr->vMode.hpe - dispPtr->vMode.hps;		/**< Horizontal Sync Width */
-	vtcTiming.HBackPorch = dispPtr->vMode.hmax - dispPtr->vMode.hpe + 1;		/**< Horizontal Back Porch Size */
-	vtcTiming.HSyncPolarity = dispPtr->vMode.hpol;	/**< Horizontal Sync Polarity */
-	vtcTiming.VActiveVideo = dispPtr->vMode.height;	/**< Vertical Active Video Size */
-	vtcTiming.V0FrontPorch = dispPtr->vMode.vps - dispPtr->vMode.height;	/**< Vertical Front Porch Size */
-	vtcTiming.V0SyncWidth = dispPtr->vMode.vpe - dispPtr->vMode.vps;	/**< Vertical Sync Width */
-	vtcTiming.V0BackPorch = dispPtr->vMode.vmax - dispPtr->vMode.vpe + 1;;	/**< Horizontal Back Porch Size */
-	vtcTiming.V1FrontPorch = dispPtr->vMode.vps - dispPtr->vMode.height;	/**< Vertical Front Porch Size */
-	vtcTiming.V1SyncWidth = dispPtr->vMode.vpe - dispPtr->vMode.vps;	/**< Vertical Sync Width */
-	vtcTiming.V1BackPorch = dispPtr->vMode.vmax - dispPtr->vMode.vpe + 1;;	/**< Horizontal Back Porch Size */
-	vtcTiming.VSyncPolarity = dispPtr->vMode.vpol;	/**< Vertical Sync Polarity */
-	vtcTiming.Interlaced = 0;		/**< Interlaced / Progressive video */
+	DisplayVtcTiming(&dispPtr->vMode, &vtcTiming);
 
 
 	/* Setup the VTC Source Select config structure. */
@@ -446,6 +466,151 @@ int DisplaySetMode(DisplayCtrl *dispPtr, const VideoMode *newMode)
 }
 /* ------------------------------------------------------------ */
 
+/***	DisplaySwitchMode(DisplayCtrl *dispPtr, const VideoMode *newMode, void *framePtr[DISPLAY_NUM_FRAMES], u32 stride)
+**
+**	Parameters:
+**		dispPtr - Pointer to the initialized DisplayCtrl struct
+**		newMode - The VideoMode struct describing the new mode.
+**		framePtr - array of pointers to the framebuffers of the new mode. The
+**				frame with index curFrame must already hold the first image
+**				to show, and none of them can be the frame currently shown.
+**		stride - line stride of the new framebuffers, in bytes
+**
+**	Return Value: int
+**		XST_SUCCESS if successful, XST_FAILURE otherwise
+**
+**	Errors:
+**
+**	Description:
+**		Changes the resolution being output to the display without stopping
+**		it. The clock parameters are found and the VDMA and VTC settings
+**		prepared beforehand, then everything is reprogrammed during a
+**		vertical blank so the new mode starts on the next frame. The vtc and
+**		VDMA latch their new settings at the frame start, the pixel clock is
+**		only restarted when the new mode needs a different one. If the
+**		display is stopped, the mode and framebuffers are stored for the
+**		next DisplayStart.
+**
+*/
+int DisplaySwitchMode(DisplayCtrl *dispPtr, const VideoMode *newMode, void *framePtr[DISPLAY_NUM_FRAMES], u32 stride)
+{
+	int Status;
+	ClkConfig clkReg;
+	ClkMode clkMode;
+	int i;
+	XVtc_Timing vtcTiming;
+	u32 clkChange;
+
+	ClkFindParams(newMode->freq, &clkMode);
+	if (!ClkFindReg(&clkReg, &clkMode))
+	{
+		xdbg_printf(XDBG_DEBUG_GENERAL, "Error calculating CLK register values\n\r");
+		return XST_FAILURE;
+	}
+	clkChange = (clkMode.freq != dispPtr->pxlFreq);
+
+	if (dispPtr->state != DISPLAY_RUNNING)
+	{
+		dispPtr->vMode = *newMode;
+		dispPtr->stride = stride;
+		for (i = 0; i < DISPLAY_NUM_FRAMES; i++)
+		{
+			dispPtr->framePtr[i] = framePtr[i];
+		}
+		return XST_SUCCESS;
+	}
+
+	DisplayVtcTiming(newMode, &vtcTiming);
+
+	dispPtr->vdmaConfig.VertSizeInput = newMode->height;
+	dispPtr->vdmaConfig.HoriSizeInput = (newMode->width) * 4;
+	dispPtr->vdmaConfig.FixedFrameStoreAddr = dispPtr->curFrame;
+	dispPtr->vdmaConfig.Stride = stride;
+	for (i = 0; i < DISPLAY_NUM_FRAMES; i++)
+	{
+		dispPtr->vdmaConfig.FrameStoreStartAddr[i] = (u32)  framePtr[i];
+	}
+
+	DisplayWaitForVBlank(dispPtr);
+
+	if (clkChange)
+	{
+		ClkWriteReg(&clkReg, dispPtr->dynClkAddr);
+		ClkStop(dispPtr->dynClkAddr);
+		ClkStart(dispPtr->dynClkAddr);
+		dispPtr->pxlFreq = clkMode.freq;
+	}
+
+	XVtc_SetGeneratorTiming(&(dispPtr->vtc), &vtcTiming);
+
+	/*
+	 * In direct register mode a running channel applies the new sizes, stride and
+	 * addresses at the next frame, the VSIZE write in XAxiVdma_DmaStart commits them.
+	 */
+	Status = XAxiVdma_DmaConfig(&dispPtr->vdma, XAXIVDMA_READ, &(dispPtr->vdmaConfig));
+	if (Status != XST_SUCCESS)
+	{
+		xdbg_printf(XDBG_DEBUG_GENERAL, "Read channel config failed %d\r\n", Status);
+		return XST_FAILURE;
+	}
+	Status = XAxiVdma_DmaSetBufferAddr(&dispPtr->vdma, XAXIVDMA_READ, dispPtr->vdmaConfig.FrameStoreStartAddr);
+	if (Status != XST_SUCCESS)
+	{
+		xdbg_printf(XDBG_DEBUG_GENERAL, "Read channel set buffer address failed %d\r\n", Status);
+		return XST_FAILURE;
+	}
+	Status = XAxiVdma_DmaStart(&dispPtr->vdma, XAXIVDMA_READ);
+	if (Status != XST_SUCCESS)
+	{
+		xdbg_printf(XDBG_DEBUG_GENERAL, "Start read transfer failed %d\r\n", Status);
+		return XST_FAILURE;
+	}
+	Status = XAxiVdma_StartParking(&dispPtr->vdma, dispPtr->curFrame, XAXIVDMA_READ);
+	if (Status != XST_SUCCESS)
+	{
+		xdbg_printf(XDBG_DEBUG_GENERAL, "Unable to park the channel %d\r\n", Status);
+		return XST_FAILURE;
+	}
+
+	dispPtr->vMode = *newMode;
+	dispPtr->stride = stride;
+	for (i = 0; i < DISPLAY_NUM_FRAMES; i++)
+	{
+		dispPtr->framePtr[i] = framePtr[i];
+	}
+
+	return XST_SUCCESS;
+}
+/* ------------------------------------------------------------ */
+
+/***	DisplayWaitForVBlank(DisplayCtrl *dispPtr)
+**
+**	Parameters:
+**		dispPtr - Pointer to the initialized DisplayCtrl struct
+**
+**	Return Value: int
+**		XST_SUCCESS if successful, XST_FAILURE otherwise
+**
+**	Errors:
+**
+**	Description:
+**		Blocks until the vtc generator enters the next vertical blank.
+**
+*/
+int DisplayWaitForVBlank(DisplayCtrl *dispPtr)
+{
+	if (dispPtr->state != DISPLAY_RUNNING)
+	{
+		return XST_FAILURE;
+	}
+
+	XVtc_IntrClear(&dispPtr->vtc, XVTC_IXR_G_VBLANK_MASK);
+	while (!(XVtc_StatusGetPending(&dispPtr->vtc) & XVTC_IXR_G_VBLANK_MASK));
+
+	return XST_SUCCESS;
+}
+/* ------------------------------------------------------------ */
+
 /***	DisplayChangeFrame(DisplayCtrl *dispPtr, u32 frameIndex)
 **
 **	Parameters:
@@ -33,7 +33,9 @@
 /*         Repeat as needed, only ever modifying inactive frames.       */
 /*      5) To change the resolution, call DisplaySetMode, followed by   */
 /*         DisplayStart again.                                          */
-/*                                                                      */
+/*      6) To change the resolution without stopping the display, draw  */
+/*         the first image of the new mode into a new set of            */
+/*         framebuffers and call DisplaySwitchMode.                     */
 /*                                                                      */
 /************************************************************************/
 /*  Revision History:                                                   */
@@ -104,6 +106,8 @@ int DisplayStop(DisplayCtrl *dispPtr);
 int DisplayStart(DisplayCtrl *dispPtr);
 int DisplayInitialize(DisplayCtrl *dispPtr, u16 vdmaId, u16 vtcId, u32 dynClkAddr, void *framePtr[DISPLAY_NUM_FRAMES], u32 stride);
 int DisplaySetMode(DisplayCtrl *dispPtr, const VideoMode *newMode);
+int DisplaySwitchMode(DisplayCtrl *dispPtr, const VideoMode *newMode, void *framePtr[DISPLAY_NUM_FRAMES], u32 stride);
+int DisplayWaitForVBlank(DisplayCtrl *dispPtr);
 int DisplayChangeFrame(DisplayCtrl *dispPtr, u32 frameIndex);
 int DisplayWaitForSync(DisplayCtrl *dispPtr);
 
@@ -40,7 +40,9 @@
  * Contains a driver for the Digilent axi_dynclk core. To use this driver:
  *
  * 1) Find the ClkMode struct for the frequency closest to your desired
- *    frequency using ClkFindParams.
+ *    frequency using ClkFindParams, or ClkFindParamsKHz to stay in integer
+ *    arithmetic. The pixel clocks of the modes in vga_modes.h come from a
+ *    precomputed table, other frequencies are searched for.
  * 2) Pass the ClkMode struct to ClkFindReg to obtain the ClkConfig struct
  *    that contains the necessary register writes that need to be made.
  * 3) Call ClkWriteReg with the ClkConfig struct and the base address of the
@@ -72,7 +74,6 @@
 
 #include "dynclk.h"
 #include "xil_io.h"
-#include "math.h"
 
 u32 ClkCountCalc(u32 divide)
 {
@@ -152,22 +153,55 @@ void ClkWriteReg (ClkConfig *regValues, u32 dynClkAddr)
 	Xil_Out32(dynClkAddr + OFST_DYNCLK_FLTR_LOCK_H, regValues->fltr_lockH);
 }
 
+/*
+ * Settings for the pixel clocks of the modes in vga_modes.h, found offline with
+ * the exhaustive double precision search this driver used to run at every mode
+ * change. Only other frequencies are searched for at run time.
+ */
+typedef struct {
+		u32 freqKHz; /* Requested pixel clock */
+		ClkMode mode;
+		u32 errorHz; /* Distance of mode.freq from the requested pixel clock */
+} ClkPreset;
+
+static const ClkPreset clkPresets[] = {
+	{  25000, { 25.0, 10, 8, 1 }, 0 },				/* VMODE_640x480 */
+	{  40000, { 40.0, 6, 3, 1 }, 0 },				/* VMODE_800x600 */
+	{ 108000, { 108.0, 54, 2, 5 }, 0 },				/* VMODE_1280x1024 */
+	{  74250, { 74.285714285714292, 52, 2, 7 }, 35714 },	/* VMODE_1280x720 */
+	{  83460, { 83.333333333333343, 25, 2, 3 }, 126667 },	/* VMODE_1280x800 */
+	{ 106470, { 106.66666666666667, 32, 2, 3 }, 196667 },	/* VMODE_1440x900 */
+	{ 147140, { 147.5, 59, 1, 8 }, 360000 }			/* VMODE_1680x1050 */
+};
+
+#define CLK_PRESET_COUNT (sizeof(clkPresets) / sizeof(clkPresets[0]))
+
 /*
  * TODO:This function currently requires that the reference clock is 100MHz.
  * 		This should be changed so that the ref. clock can be specified, or read directly
  * 		out of hardware. This has been done in the linux driver, it just needs to be
  * 		ported here.
  */
-double ClkFindParams(double freq, ClkMode *bestPick)
+u32 ClkFindParamsKHz(u32 freqKHz, ClkMode *bestPick)
 {
-	double bestError = 2000.0;
-	double curError;
-	double curClkMult;
-	double curFreq;
+	u32 i;
+	u32 target;
 	u32 curDiv, curFb, curClkDiv;
+	u32 curVco, curDen, curError;
+	u32 bestDen = 0;
+	u32 bestError = 0;
 	u32 minFb = 0;
 	u32 maxFb = 0;
 
+	for (i = 0; i < CLK_PRESET_COUNT; i++)
+	{
+		if (clkPresets[i].freqKHz == freqKHz)
+		{
+			*bestPick = clkPresets[i].mode;
+			return clkPresets[i].errorHz;
+		}
+	}
+
 	/*
 	 * This is necessary because the MMCM actual is generating 5x the desired pixel clock, and that
 	 * clock is then run through a BUFR that divides it by 5 to generate the pixel clock. Note this
@@ -175,12 +209,21 @@ double ClkFindParams(double freq, ClkMode *bestPick)
 	 * future if options like these are parameterized in the axi_dynclk core, then this function will
 	 * need to change.
 	 */
-	freq = freq * 5.0;
+	target = freqKHz * 5;
 
 	bestPick->freq = 0.0;
-/*
- * TODO: replace with a smarter algorithm that doesn't doesn't check every possible combination
- */
+	bestPick->fbmult = 0;
+	bestPick->clkdiv = 0;
+	bestPick->maindiv = 0;
+
+	if ((freqKHz == 0) || (freqKHz > CLK_MAX_FREQ_KHZ))
+		return ERR_CLKFINDPARAMS;
+
+	/*
+	 * The output is curVco / curDen kHz. For every divider and feedback value only the
+	 * nearest output divider is tried, and the errors curError / curDen are compared by
+	 * cross multiplication so no division or floating point is needed.
+	 */
 	for (curDiv = 1; curDiv <= 10; curDiv++)
 	{
 		minFb = curDiv * 6; //This accounts for the 100MHz input and the 600MHz minimum VCO
@@ -188,36 +231,51 @@ double ClkFindParams(double freq, ClkMode *bestPick)
 		if (maxFb > 64)
 			maxFb = 64;
 
-		curClkMult = (100.0 / (double) curDiv) / freq; //This multiplier is used to find the best clkDiv value for each FB value
-
-		curFb = minFb;
-		while (curFb <= maxFb)
+		for (curFb = minFb; curFb <= maxFb; curFb++)
 		{
-			curClkDiv = (u32) ((curClkMult * (double)curFb) + 0.5);
-			curFreq = ((100.0 / (double) curDiv) / (double) curClkDiv) * (double) curFb;
-			curError = fabs(curFreq - freq);
-			if (curError < bestError)
+			curVco = 100000 * curFb;
+			curClkDiv = (2 * curVco + curDiv * target) / (2 * curDiv * target);
+			if ((curClkDiv < 1) || (curClkDiv > 128))
+				continue;
+
+			curDen = curDiv * curClkDiv;
+			if (curVco > target * curDen)
+				curError = curVco - target * curDen;
+			else
+				curError = target * curDen - curVco;
+
+			if ((bestDen == 0) || ((u64) curError * bestDen < (u64) bestError * curDen))
 			{
 				bestError = curError;
+				bestDen = curDen;
 				bestPick->clkdiv = curClkDiv;
 				bestPick->fbmult = curFb;
 				bestPick->maindiv = curDiv;
-				bestPick->freq = curFreq;
 			}
-
-			curFb++;
 		}
 	}
 
+	if (bestDen == 0)
+		return ERR_CLKFINDPARAMS;
+
 	/*
-	 * We want the ClkMode struct and errors to be based on the desired frequency. Need to check this doesn't introduce
-	 * rounding errors.
+	 * We want the ClkMode struct and errors to be based on the desired frequency.
 	 */
-	bestPick->freq = bestPick->freq / 5.0;
-	bestError = bestError / 5.0;
-	return bestError;
+	bestPick->freq = ((100.0 / (double) bestPick->maindiv) / (double) bestPick->clkdiv)
+			* (double) bestPick->fbmult / 5.0;
+	return (200 * bestError + bestDen / 2) / bestDen;
 }
 
+double ClkFindParams(double freq, ClkMode *bestPick)
+{
+	u32 errorHz;
+
+	errorHz = ClkFindParamsKHz((u32) (freq * 1000.0 + 0.5), bestPick);
+	if (errorHz == ERR_CLKFINDPARAMS)
+		return -1.0;
+
+	return (double) errorHz / 1000000.0;
+}
 
 void ClkStart(u32 dynClkAddr)
 {
@@ -40,7 +40,9 @@
  * Contains a driver for the Digilent axi_dynclk core. To use this driver:
  *
  * 1) Find the ClkMode struct for the frequency closest to your desired
- *    frequency using ClkFindParams.
+ *    frequency using ClkFindParams, or ClkFindParamsKHz to stay in integer
+ *    arithmetic. The pixel clocks of the modes in vga_modes.h come from a
+ *    precomputed table, other frequencies are searched for.
  * 2) Pass the ClkMode struct to ClkFindReg to obtain the ClkConfig struct
  *    that contains the necessary register writes that need to be made.
  * 3) Call ClkWriteReg with the ClkConfig struct and the base address of the
@@ -87,6 +89,10 @@
 
 #define ERR_CLKCOUNTCALC 0xFFFFFFFF //This value is used to signal an error
 
+#define ERR_CLKFINDPARAMS 0xFFFFFFFF //No setting generates the requested frequency
+
+#define CLK_MAX_FREQ_KHZ 1000000 //Keeps the integer search from overflowing
+
 #define OFST_DYNCLK_CTRL 0x0
 #define OFST_DYNCLK_STATUS 0x4
 #define OFST_DYNCLK_CLK_L 0x8
@@ -265,6 +271,7 @@ u32 ClkCountCalc(u32 divide);
 u32 ClkDivider(u32 divide);
 u32 ClkFindReg (ClkConfig *regValues, ClkMode *clkParams);
 void ClkWriteReg (ClkConfig *regValues, u32 dynClkAddr);
+u32 ClkFindParamsKHz(u32 freqKHz, ClkMode *bestPick);
 double ClkFindParams(double freq, ClkMode *bestPick);
 void ClkStart(u32 dynClkAddr);
 void ClkStop(u32 dynClkAddr);